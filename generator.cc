@@ -3,11 +3,18 @@
 
 #include <eacirc-core/logger.h>
 #include <eacirc-core/random.h>
+#include <eacirc-core/version.h>
 #include <pcg/pcg_random.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <set>
 #include <sstream>
+#include <thread>
 
 static std::ifstream open_config_file(const std::string path) {
     std::ifstream file(path);
@@ -16,18 +23,64 @@ static std::ifstream open_config_file(const std::string path) {
     return file;
 }
 
-static std::string out_name(json const &config) {
+// node of the primitive, the first one with an algorithm down the sources of the stream
+template <typename Json> static Json &primitive(Json &stream) {
+    Json *node = &stream;
+    // this allows finding name hidden in postprocessing streams
+    while (node->find("algorithm") == node->end()) {
+        node = &node->at("source");
+    }
+    return *node;
+}
+
+/**
+ * Variant of a sweep, the config with one value of every swept parameter of the primitive and
+ * those values as text for the file name: a scalar as it is, a structured one by its index in
+ * the list of the sweep
+ */
+struct sweep_variant {
+    json config;
+    std::vector<std::pair<std::string, std::string>> parameters;
+};
+
+// a parameter of the primitive in a file name, the swept text or the scalar value set on it
+static std::string parameter_text(const sweep_variant &variant, const std::string &key) {
+    for (const auto &parameter : variant.parameters)
+        if (parameter.first == key)
+            return parameter.second;
+
+    const json &config_ref = primitive(variant.config.at("stream"));
+    auto value_it = config_ref.find(key);
+    if (value_it == config_ref.end() || value_it->is_structured())
+        throw std::runtime_error("file name has {" + key +
+                                 "}, which is not a value of the primitive");
+    return value_it->is_string() ? value_it->get<std::string>() : value_it->dump();
+}
+
+// "file_name" with the placeholders {parameter} replaced by the values of the variant
+static std::string expand_file_name(const std::string &name, const sweep_variant &variant) {
+    std::string expanded;
+    for (std::size_t i = 0; i < name.size();) {
+        const std::size_t end = name.find('}', i);
+        if (name[i] != '{' || end == std::string::npos) {
+            expanded += name[i++];
+            continue;
+        }
+        expanded += parameter_text(variant, name.substr(i + 1, end - i - 1));
+        i = end + 1;
+    }
+    return expanded;
+}
+
+static std::string out_name(const sweep_variant &variant) {
+    const json &config = variant.config;
     auto fname_it = config.find("file_name");
     if (fname_it != config.end()) {
-        return *fname_it;
+        return expand_file_name(*fname_it, variant);
     }
 
     std::stringstream ss;
-    json config_ref = config.at("stream");
-    // this allows finding name hidden in postprocessing streams
-    while (config_ref.find("algorithm") == config_ref.end()) {
-        config_ref = config_ref.at("source");
-    }
+    const json &config_ref = primitive(config.at("stream"));
     std::string a = config_ref.at("algorithm");
 
     ss << a;
@@ -43,10 +96,164 @@ static std::string out_name(json const &config) {
         ss << "_b" << block_size;
     }
 
+    // the other swept parameters tell the variants apart
+    for (const auto &parameter : variant.parameters)
+        if (parameter.first != "algorithm" && parameter.first != "round" &&
+            parameter.first != "block_size")
+            ss << "_" << parameter.first << parameter.second;
+
     ss << ".bin";
     return ss.str();
 }
 
+// text of a swept value in the file name
+static std::string sweep_text(const json &value, const std::size_t index) {
+    if (value.is_structured())
+        return std::to_string(index);
+    return value.is_string() ? value.get<std::string>() : value.dump();
+}
+
+// every combination of the values in "sweep" set on the primitive
+static std::vector<sweep_variant> sweep_variants(const json &config) {
+    std::vector<sweep_variant> variants = {{config, {}}};
+    auto sweep_it = config.find("sweep");
+    if (sweep_it == config.end())
+        return variants;
+
+    variants.front().config.erase("sweep");
+
+    for (auto parameter = sweep_it->begin(); parameter != sweep_it->end(); ++parameter) {
+        if (!parameter->is_array() || parameter->empty())
+            throw std::runtime_error("sweep of \"" + parameter.key() +
+                                     "\" is not a list of values");
+
+        std::vector<sweep_variant> expanded;
+        for (const sweep_variant &variant : variants)
+            for (std::size_t i = 0; i < parameter->size(); ++i) {
+                expanded.push_back(variant);
+                primitive(expanded.back().config.at("stream"))[parameter.key()] = (*parameter)[i];
+                expanded.back().parameters.emplace_back(parameter.key(),
+                                                        sweep_text((*parameter)[i], i));
+            }
+        variants = std::move(expanded);
+    }
+    return variants;
+}
+
+// vectors the variants of a sweep advance at a time, a shared input keeps the vectors of a round
+// (a quarter of what it may keep, an input may be read faster than the output)
+static std::uint64_t sweep_round(const std::uint64_t tv_size) {
+    return std::max<std::uint64_t>(
+        1, std::min<std::uint64_t>(1024, _impl::shared_source::max_kept_size / 4 / tv_size));
+}
+
+// the variants of a sweep read one stream of every input of the primitive named by its slot, an
+// input shared only when it starts as in a run of the variant alone; inputs of vectors too long
+// to keep for a round are not
+static json share_inputs(json config) {
+    if (sweep_round(config.at("tv_size")) * std::uint64_t(config.at("tv_size")) * 4 >
+        _impl::shared_source::max_kept_size)
+        return config;
+
+    json &node = primitive(config.at("stream"));
+    for (auto input = node.begin(); input != node.end(); ++input)
+        if (input->is_object() && input->count("type") && !input->count("share"))
+            (*input)["share"] = input.key();
+    return config;
+}
+
+// a file read by the stream may change, the output is not given by the config then
+static bool reads_files(const json &node) {
+    if (node.is_object() && node.value("type", "") == "file_stream")
+        return true;
+    if (node.is_structured())
+        for (const auto &child : node)
+            if (reads_files(child))
+                return true;
+    return false;
+}
+
+// the config without the entries which do not change the bytes of the output, and the version
+// the bytes are generated by. The count only sets how many vectors there are.
+static json output_config(json config) {
+    for (const char *key : {"tv_count", "file_name", "stdout", "threads", "cache", "checkpoint"})
+        config.erase(key);
+    config["version"] = VERSION_TAG;
+    return config;
+}
+
+// text of the config which gives the bytes of the output, empty when they are not given by it
+static std::string cache_key(const json &config) {
+    if (config.at("seed").is_null() || reads_files(config.at("stream")))
+        return {};
+    return output_config(config).dump();
+}
+
+/**
+ * Checkpoint of an output, written next to it: the canonical config of the output and of the
+ * whole run, the count of vectors in the output and the state of its streams after them, if
+ * they could save it. It is written aside and renamed, a run killed meanwhile keeps the previous
+ * one. The state is read by the very same build only, the version is in the configs. The state
+ * stored with an output in the cache is read into one as well.
+ */
+struct checkpoint {
+    std::uint64_t count = 0;
+    std::string run;
+    bool has_state = false;
+    std::string state;
+};
+
+static const std::string checkpoint_magic = "crypto-streams checkpoint 1\n";
+
+static std::string checkpoint_path(const std::string &output) {
+    return output + ".checkpoint";
+}
+
+static std::uint64_t file_size(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? std::uint64_t(file.tellg()) : 0;
+}
+
+// the checkpoint of the output with the key, count 0 when there is none
+static checkpoint read_checkpoint(const std::string &output, const std::string &key) {
+    std::ifstream file(checkpoint_path(output), std::ios::binary);
+    std::string magic(checkpoint_magic.size(), '\0');
+    if (!file.read(&magic[0], std::streamsize(magic.size())) || magic != checkpoint_magic)
+        return {};
+
+    checkpoint saved;
+    try {
+        std::string saved_key;
+        stream_state::read(file, saved_key);
+        if (saved_key != key)
+            return {};
+        stream_state::read(file, saved.run);
+        stream_state::read(file, saved.count);
+        stream_state::read(file, saved.has_state);
+        if (saved.has_state)
+            stream_state::read(file, saved.state);
+    } catch (std::runtime_error &) {
+        return {};
+    }
+    return saved;
+}
+
+static void skip_vectors(stream &source, const std::uint64_t count) {
+    for (std::uint64_t i = 0; i < count; ++i)
+        source.next();
+}
+
+static void write_vectors(stream &source, std::ostream &o_file, const std::uint64_t count) {
+    for (std::uint64_t i = 0; i < count; ++i) {
+        vec_cview n = source.next();
+        for (auto o : n)
+            o_file << o;
+        // a full disk, or a consumer of the server gone
+        if (!o_file)
+            throw std::runtime_error("cannot write the output");
+    }
+}
+
 generator::generator(const std::string config)
     : generator(open_config_file(config)) {}
 
@@ -54,29 +261,296 @@ generator::generator(json const &config)
     : _config(config)
     , _seed(seed::create(config.at("seed")))
     , _tv_count(config.at("tv_count"))
-    , _o_file_name(out_name(config)) {
-    seed_seq_from<pcg32> main_seeder(_seed);
-    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    , _checkpoint(config.value("checkpoint", std::uint64_t(0)))
+    , _run_key(output_config(config).dump()) {
+    if (config.count("cache"))
+        _cache = std::make_unique<output_cache>(config.at("cache"));
+    if (_checkpoint != 0 && config.at("seed").is_null())
+        throw std::runtime_error("checkpoints need a fixed seed, a random one cannot be resumed");
+
+    // subgraphs shared by the variants, the pipes are those of each variant
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> shared;
+    const std::vector<sweep_variant> variants = sweep_variants(config);
+
+    for (const sweep_variant &swept : variants) {
+        const json &variant = swept.config;
+        // seeded as a run of its own, every input is built with the seeder as in that run
+        seed_seq_from<pcg32> main_seeder(_seed);
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map = shared;
 
-    _stream_a = make_stream(config.at("stream"), main_seeder, map, std::size_t(config.at("tv_size")));
+        const json stream_config =
+            variants.size() > 1 ? share_inputs(variant).at("stream") : variant.at("stream");
+        _streams.push_back(
+            make_stream(stream_config, main_seeder, map, std::size_t(config.at("tv_size"))));
+        _o_file_names.push_back(out_name(swept));
+        // a variant gives the bytes of a run of it alone, they are cached under the same key
+        _cache_keys.push_back(cache_key(variant));
+        _checkpoint_keys.push_back(output_config(variant).dump());
+        add_shared_subgraphs(map, shared);
+    }
+
+    if (_streams.size() > 1) {
+        if (config.value("stdout", false) || config.count("shm"))
+            throw std::runtime_error("variants of a sweep cannot be written to one stream");
+        if (std::set<std::string>(_o_file_names.begin(), _o_file_names.end()).size() !=
+            _o_file_names.size())
+            throw std::runtime_error("variants of the sweep are written to the same file, "
+                                     "put the swept parameters in the file name as {name}");
+    }
 }
 
 void generator::generate() {
-
     auto stdout_it = _config.find("stdout");
-    std::unique_ptr<std::ostream> ofstream_ptr;
-    std::ostream *o_file = nullptr;
+    if (stdout_it != _config.end() && stdout_it->get<bool>() == true) {
+        generate(std::cout);
+        return;
+    }
+    // "shm" names the ring, "shm_slots" (1024 by default) is its capacity in vectors
+    auto shm_it = _config.find("shm");
+    if (shm_it != _config.end()) {
+        shm_ring ring(*shm_it,
+                      std::size_t(_config.at("tv_size")),
+                      _config.value("shm_slots", std::uint64_t(1024)),
+                      _tv_count);
+        generate(ring);
+        return;
+    }
+
+    std::vector<std::uint64_t> done(_streams.size(), 0);
+    const std::uint64_t start = restore_cached(done, resume_checkpoints(done));
+    // a complete output needs nothing more, its stream does not hold back the shared ones
+    for (std::size_t v = 0; v < _streams.size(); ++v)
+        if (done[v] == _tv_count)
+            _streams[v].reset();
+
+    generate_files(done, start);
+    store_cached(done);
+}
+
+void generator::require_single_output(const std::string &target) const {
+    if (_streams.size() > 1)
+        throw std::runtime_error("variants of a sweep cannot be written to one " + target);
+}
+
+void generator::generate(std::ostream &out) {
+    require_single_output("stream");
+    write_vectors(*_streams.front(), out, _tv_count);
+    out.flush();
+}
 
-    if (stdout_it == _config.end() || stdout_it->get<bool>() == false) {
-        ofstream_ptr = std::make_unique<std::ofstream>(_o_file_name, std::ios::binary);
-        o_file = ofstream_ptr.get();
-    } else {
-        o_file = &(std::cout);
+void generator::generate(shm_ring &ring) {
+    require_single_output("ring");
+
+    // the vectors are written to the slots right away, a run of free slots is published at once
+    stream &source = *_streams.front();
+    for (std::uint64_t done = 0; done < _tv_count;) {
+        const std::uint64_t count = ring.wait_free(_tv_count - done);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            vec_cview vector = source.next();
+            std::copy(vector.begin(), vector.end(), ring.slot(done + i));
+        }
+        ring.publish(count);
+        done += count;
     }
+}
 
-    for (std::size_t i = 0; i < _tv_count; ++i) {
-        vec_cview n = _stream_a->next();
-        for (auto o : n)
-            *o_file << o;
+std::uint64_t generator::resume_checkpoints(std::vector<std::uint64_t> &done) {
+    if (_checkpoint == 0)
+        return 0;
+
+    const std::uint64_t tv_size = _config.at("tv_size");
+    std::vector<checkpoint> saved(_streams.size());
+    for (std::size_t v = 0; v < _streams.size(); ++v) {
+        saved[v] = read_checkpoint(_o_file_names[v], _checkpoint_keys[v]);
+        if (saved[v].count == 0 || file_size(_o_file_names[v]) < saved[v].count * tv_size) {
+            saved[v] = checkpoint();
+            continue;
+        }
+
+        done[v] = std::min(saved[v].count, _tv_count);
+        output_cache::truncate(_o_file_names[v], done[v] * tv_size);
+        logger::info() << _o_file_names[v] << ": " << done[v] << " of " << _tv_count
+                       << " vectors kept from the checkpoint" << std::endl;
+    }
+
+    return load_states(saved, done);
+}
+
+std::uint64_t generator::load_states(const std::vector<checkpoint> &saved,
+                                     const std::vector<std::uint64_t> &done) {
+    // the unfinished outputs may share subgraphs, their states are loaded all together or not
+    std::uint64_t start = 0;
+    for (std::size_t v = 0; v < _streams.size(); ++v) {
+        if (done[v] == _tv_count)
+            continue;
+        if (!saved[v].has_state || saved[v].run != _run_key || saved[v].count != done[v] ||
+            (start != 0 && saved[v].count != start))
+            return 0;
+        start = saved[v].count;
+    }
+
+    for (std::size_t v = 0; v < _streams.size(); ++v) {
+        if (done[v] == _tv_count)
+            continue;
+        std::istringstream state(saved[v].state);
+        _streams[v]->load_state(state);
+    }
+    return start;
+}
+
+bool generator::save_streams(const std::size_t variant, std::string &state) const {
+    std::ostringstream out;
+    try {
+        _streams[variant]->save_state(out);
+    } catch (std::runtime_error &e) {
+        logger::info() << _o_file_names[variant] << ": state of the streams not saved, "
+                       << e.what() << std::endl;
+        return false;
+    }
+    state = out.str();
+    return true;
+}
+
+void generator::write_checkpoint(const std::size_t variant, const std::uint64_t count) {
+    // without the state a resumed run computes the vectors in the output again
+    std::string state;
+    const bool has_state = save_streams(variant, state);
+
+    const std::string path = checkpoint_path(_o_file_names[variant]);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(checkpoint_magic.data(), std::streamsize(checkpoint_magic.size()));
+        stream_state::write(file, _checkpoint_keys[variant]);
+        stream_state::write(file, _run_key);
+        stream_state::write(file, count);
+        stream_state::write(file, has_state);
+        if (has_state)
+            stream_state::write(file, state);
+        if (!file.flush())
+            throw std::runtime_error("cannot write checkpoint " + temporary);
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("cannot write checkpoint " + path);
+}
+
+std::uint64_t generator::restore_cached(std::vector<std::uint64_t> &done,
+                                        const std::uint64_t start) {
+    if (!_cache)
+        return start;
+
+    const std::uint64_t tv_size = _config.at("tv_size");
+    std::vector<checkpoint> saved(_streams.size());
+    for (std::size_t v = 0; v < _streams.size(); ++v) {
+        // the output kept from a checkpoint may be newer than the cached one
+        if (_cache_keys[v].empty() || done[v] > 0)
+            continue;
+
+        done[v] = _cache->restore(_cache_keys[v], _o_file_names[v], _tv_count * tv_size) /
+                  tv_size;
+        if (done[v] == 0)
+            continue;
+        logger::info() << _o_file_names[v] << ": " << done[v] << " of " << _tv_count
+                       << " vectors taken from the cache" << std::endl;
+
+        std::istringstream state(_cache->state(_cache_keys[v]));
+        try {
+            stream_state::read(state, saved[v].run);
+            stream_state::read(state, saved[v].count);
+            stream_state::read(state, saved[v].state);
+            saved[v].has_state = true;
+        } catch (std::runtime_error &) {
+            saved[v] = checkpoint();
+        }
+    }
+
+    // the streams of a checkpoint are loaded already
+    return start != 0 ? start : load_states(saved, done);
+}
+
+void generator::store_cached(const std::vector<std::uint64_t> &done) {
+    if (!_cache)
+        return;
+    for (std::size_t v = 0; v < _streams.size(); ++v) {
+        if (_cache_keys[v].empty() || done[v] == _tv_count)
+            continue;
+
+        // the streams are after the last vector of the output, an extension goes on from them
+        std::string state;
+        std::ostringstream saved;
+        if (save_streams(v, state)) {
+            stream_state::write(saved, _run_key);
+            stream_state::write(saved, _tv_count);
+            stream_state::write(saved, state);
+        }
+        _cache->store(_cache_keys[v], _o_file_names[v], saved.str());
+    }
+}
+
+void generator::generate_files(const std::vector<std::uint64_t> &done, const std::uint64_t start) {
+    // the outputs with vectors from a checkpoint or the cache are extended, the others written
+    // anew; an output may be linked to an entry of the cache, its file is never rewritten
+    const std::uint64_t tv_size = _config.at("tv_size");
+    std::vector<std::ofstream> o_files(_streams.size());
+    for (std::size_t v = 0; v < _streams.size(); ++v) {
+        if (!_streams[v])
+            continue;
+        if (done[v] > 0) {
+            output_cache::truncate(_o_file_names[v], done[v] * tv_size);
+            o_files[v].open(_o_file_names[v], std::ios::binary | std::ios::app);
+        } else {
+            std::remove(_o_file_names[v].c_str());
+            o_files[v].open(_o_file_names[v], std::ios::binary | std::ios::trunc);
+        }
+        if (!o_files[v])
+            throw std::runtime_error("cannot open output " + _o_file_names[v]);
+    }
+
+    const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t threads =
+        std::min(_streams.size(), std::size_t(_config.value("threads", hardware_threads)));
+    if (threads == 0)
+        throw std::runtime_error("sweep needs at least one thread");
+
+    // the variants advance a round at a time, the shared inputs keep the vectors of one round,
+    // a checkpoint is taken between two rounds
+    const std::uint64_t round = sweep_round(tv_size);
+    std::uint64_t next_checkpoint = _checkpoint != 0 ? start + _checkpoint : _tv_count;
+    for (std::uint64_t first = start; first < _tv_count;) {
+        const std::uint64_t count =
+            std::min(std::min(round, _tv_count - first), next_checkpoint - first);
+        std::atomic<std::size_t> next_variant(0);
+        const auto work = [&] {
+            for (std::size_t v; (v = next_variant++) < _streams.size();) {
+                if (!_streams[v])
+                    continue;
+                // the streams compute the vectors in the output again, they are not written
+                const std::uint64_t skipped =
+                    std::min(count, done[v] > first ? done[v] - first : std::uint64_t(0));
+                skip_vectors(*_streams[v], skipped);
+                write_vectors(*_streams[v], o_files[v], count - skipped);
+            }
+        };
+
+        std::vector<std::future<void>> workers;
+        for (std::size_t t = 1; t < threads; ++t)
+            workers.push_back(std::async(std::launch::async, work));
+        work();
+        // rethrows the failures of the workers
+        for (auto &worker : workers)
+            worker.get();
+
+        first += count;
+        if (_checkpoint == 0 || (first != next_checkpoint && first != _tv_count))
+            continue;
+        next_checkpoint += _checkpoint;
+        for (std::size_t v = 0; v < _streams.size(); ++v) {
+            // an output longer than the vectors generated so far keeps its old checkpoint
+            if (!_streams[v] || done[v] > first)
+                continue;
+            if (!o_files[v].flush())
+                throw std::runtime_error("cannot write output " + _o_file_names[v]);
+            write_checkpoint(v, first);
+        }
     }
 }
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "output_cache.h"
+#include "shm_ring.h"
 #include "stream.h"
 #include <eacirc-core/json.h>
 #include <eacirc-core/seed.h>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <vector>
+
+// output kept from an earlier run and the state of its streams after it, see generator.cc
+struct checkpoint;
 
 struct generator {
     generator(const std::string cofig);
@@ -23,13 +29,66 @@ struct generator {
 
     void generate();
 
+    /** Writes the vectors to out instead of the files, a sweep has more outputs than one */
+    void generate(std::ostream &out);
+
+    /** Throws unless the config has a single output, one target (as "stream") can take it */
+    void require_single_output(const std::string &target) const;
+
+    /** Publishes the vectors to a ring in shared memory instead of the files */
+    void generate(shm_ring &ring);
+
 private:
+    /**
+     * Vectors of every output kept from the checkpoint of an earlier run, the outputs are cut
+     * to them. When every unfinished output has the state of its streams saved after the same
+     * vector, the states are loaded and the index of the vector is returned, otherwise 0 and the
+     * streams compute the kept vectors again.
+     */
+    std::uint64_t resume_checkpoints(std::vector<std::uint64_t> &done);
+    void write_checkpoint(std::size_t variant, std::uint64_t count);
+
+    /**
+     * Loads the saved states of the unfinished outputs when each of them is after its done
+     * vectors, the same for all, and saved in a run of the same config. Returns the index of the
+     * vector, 0 when nothing was loaded.
+     */
+    std::uint64_t load_states(const std::vector<checkpoint> &saved,
+                              const std::vector<std::uint64_t> &done);
+    // state of the streams of the output, false when some of them cannot save it
+    bool save_streams(std::size_t variant, std::string &state) const;
+
+    /**
+     * Vectors of the outputs without a checkpoint taken from the cache. Returns the vector the
+     * streams are at, the one of start, or of the states stored with the cached outputs.
+     */
+    std::uint64_t restore_cached(std::vector<std::uint64_t> &done, std::uint64_t start);
+    // the extended outputs with the state of their streams
+    void store_cached(const std::vector<std::uint64_t> &done);
+
+    /**
+     * Writes the outputs after their done vectors, side by side on "threads" workers. The streams
+     * are at vector start, a checkpoint is written every "checkpoint" vectors.
+     */
+    void generate_files(const std::vector<std::uint64_t> &done, std::uint64_t start);
+
     const json _config;
     const seed _seed;
 
     const std::uint64_t _tv_count;
 
-    std::unique_ptr<stream> _stream_a;
+    // one stream and output file per variant of the sweep, a single one without a sweep
+    std::vector<std::unique_ptr<stream>> _streams;
+    std::vector<std::string> _o_file_names;
+
+    // outputs of the configs generated before, "cache" is their directory
+    std::unique_ptr<output_cache> _cache;
+    // canonical config of every output, empty when it is not cached
+    std::vector<std::string> _cache_keys;
 
-    std::string _o_file_name;
+    // vectors between two checkpoints, 0 without them
+    const std::uint64_t _checkpoint;
+    // canonical config of every output and of the whole run, a checkpoint is taken only by them
+    std::vector<std::string> _checkpoint_keys;
+    std::string _run_key;
 };
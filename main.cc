@@ -1,8 +1,22 @@
 #include "generator.h"
+#include "server.h"
+#include "streams.h"
 #include <eacirc-core/cmd.h>
 #include <eacirc-core/logger.h>
 #include <eacirc-core/version.h>
+#include <algorithm>
 #include <limits>
+#include <thread>
+
+#ifdef BUILD_stream_ciphers
+#include <streams/stream_ciphers/stream_cipher.h>
+#endif
+#ifdef BUILD_hash
+#include <streams/hash/hash_factory.h>
+#endif
+#ifdef BUILD_block
+#include <streams/block/block_factory.h>
+#endif
 
 void test_environment() {
     if (std::numeric_limits<std::uint8_t>::max() != 255)
@@ -11,15 +25,42 @@ void test_environment() {
         throw std::range_error("Unsigned char does not have 8 bits");
 }
 
+static void list_names(const std::string &title, const std::vector<std::string> &names) {
+    std::cout << title << ":" << std::endl;
+    for (const auto &name : names)
+        std::cout << "  " << name << std::endl;
+}
+
+void list_primitives() {
+    list_names("stream types", stream_types().names());
+#ifdef BUILD_stream_ciphers
+    list_names("stream ciphers (\"stream_cipher\" algorithm)",
+               stream_ciphers::stream_cipher_names());
+#endif
+#ifdef BUILD_hash
+    list_names("hash functions (\"hash\" algorithm)", hash::hash_factory::algorithms());
+#endif
+#ifdef BUILD_block
+    list_names("block ciphers (\"block\" algorithm)", block::block_cipher_names());
+#endif
+}
+
 struct config {
     bool help = false;
     bool version = false;
+    bool list = false;
     std::string config = "generator.json";
+    std::string serve;
 };
 
 static cmd<config> options{{"-h", "--help", "display help message", &config::help},
                            {"-v", "--version", "display program version", &config::version},
-                           {"-c", "--config", "specify the config file to load", &config::config}};
+                           {"-l", "--list", "list the available primitives", &config::list},
+                           {"-c", "--config", "specify the config file to load", &config::config},
+                           {"-s",
+                            "--serve",
+                            "serve the streams of configs sent to a Unix socket at the path",
+                            &config::serve}};
 
 int main(const int argc, const char **argv) try {
     auto cfg = options.parse(make_view(argv, argc));
@@ -30,6 +71,13 @@ int main(const int argc, const char **argv) try {
         options.print(std::cerr);
     } else if (cfg.version) {
         std::cerr << "Generator version " VERSION_TAG << std::endl;
+    } else if (cfg.list) {
+        list_primitives();
+    } else if (!cfg.serve.empty()) {
+        test_environment();
+
+        stream_server server(cfg.serve);
+        server.run(std::max(1u, std::thread::hardware_concurrency()));
     } else {
         test_environment();
 
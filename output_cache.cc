@@ -0,0 +1,209 @@
+#include "output_cache.h"
+#include "posix.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef CRYPTO_STREAMS_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef CRYPTO_STREAMS_POSIX
+
+// 64-bit FNV-1a, the entries are told apart by the stored key anyway
+static std::string key_hash(const std::string &key) {
+    std::uint64_t hash = 0xcbf29ce484222325u;
+    for (const char c : key) {
+        hash ^= std::uint8_t(c);
+        hash *= 0x100000001b3u;
+    }
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+static std::uint64_t file_size(const std::string &path) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0)
+        return 0;
+    return std::uint64_t(info.st_size);
+}
+
+// the first size bytes of from to a new file to, reflinked when it is the whole file
+static void copy_file(const std::string &from, const std::string &to, const std::uint64_t size) {
+    const int in = ::open(from.c_str(), O_RDONLY);
+    if (in == -1)
+        throw_errno("open", from);
+    const int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (out == -1) {
+        ::close(in);
+        throw_errno("create", to);
+    }
+
+#ifdef FICLONE
+    if (size == file_size(from) && ::ioctl(out, FICLONE, in) == 0) {
+        ::close(in);
+        ::close(out);
+        return;
+    }
+#endif
+
+    std::vector<char> buffer(std::size_t(1) << 20);
+    for (std::uint64_t copied = 0; copied < size;) {
+        const auto chunk = std::size_t(std::min<std::uint64_t>(buffer.size(), size - copied));
+        const ssize_t read = ::read(in, buffer.data(), chunk);
+        if (read <= 0 || ::write(out, buffer.data(), std::size_t(read)) != read) {
+            ::close(in);
+            ::close(out);
+            throw_errno("copy to", to);
+        }
+        copied += std::uint64_t(read);
+    }
+    ::close(in);
+    if (::close(out) != 0)
+        throw_errno("write", to);
+}
+
+output_cache::output_cache(const std::string &directory)
+    : _directory(directory) {
+    if (::mkdir(_directory.c_str(), 0777) != 0 && errno != EEXIST)
+        throw_errno("create cache directory", _directory);
+}
+
+std::string output_cache::entry(const std::string &key) const {
+    return _directory + "/" + key_hash(key);
+}
+
+std::uint64_t output_cache::cached_size(const std::string &key) const {
+    std::ifstream stored_key(entry(key) + ".json", std::ios::binary);
+    std::stringstream text;
+    text << stored_key.rdbuf();
+    if (!stored_key || text.str() != key)
+        return 0;
+    return file_size(entry(key) + ".bin");
+}
+
+std::uint64_t
+output_cache::restore(const std::string &key, const std::string &path, const std::uint64_t size) {
+    // the old output may be linked to an entry, it must not be rewritten
+    if (::unlink(path.c_str()) != 0 && errno != ENOENT)
+        throw_errno("remove", path);
+
+    const std::uint64_t cached = cached_size(key);
+    const std::uint64_t restored = std::min(cached, size);
+    if (restored == 0)
+        return 0;
+
+    // a whole output that stays as it is can be the entry itself
+    const std::string output = entry(key) + ".bin";
+    if (restored != size || restored != cached || ::link(output.c_str(), path.c_str()) != 0)
+        copy_file(output, path, restored);
+    return restored;
+}
+
+void output_cache::store(const std::string &key,
+                         const std::string &path,
+                         const std::string &state) {
+    const std::uint64_t size = file_size(path);
+    if (size <= cached_size(key))
+        return;
+
+    // written aside and renamed, concurrent generators see either the old entry or the new one
+    const std::string base = entry(key);
+    const std::string temporary = base + "." + std::to_string(::getpid()) + ".tmp";
+    {
+        std::ofstream stored_key(temporary, std::ios::binary);
+        stored_key << key;
+        if (!stored_key.flush())
+            throw_errno("write", temporary);
+    }
+    if (::rename(temporary.c_str(), (base + ".json").c_str()) != 0)
+        throw_errno("store", base + ".json");
+
+    if (::link(path.c_str(), temporary.c_str()) != 0)
+        copy_file(path, temporary, size);
+    if (::rename(temporary.c_str(), (base + ".bin").c_str()) != 0)
+        throw_errno("store", base + ".bin");
+
+    // a state left from a shorter output does not match the new one, the reader checks it
+    if (state.empty()) {
+        ::unlink((base + ".state").c_str());
+        return;
+    }
+    {
+        std::ofstream stored_state(temporary, std::ios::binary);
+        stored_state << state;
+        if (!stored_state.flush())
+            throw_errno("write", temporary);
+    }
+    if (::rename(temporary.c_str(), (base + ".state").c_str()) != 0)
+        throw_errno("store", base + ".state");
+}
+
+std::string output_cache::state(const std::string &key) const {
+    if (cached_size(key) == 0)
+        return {};
+    std::ifstream stored_state(entry(key) + ".state", std::ios::binary);
+    std::stringstream text;
+    text << stored_state.rdbuf();
+    return text.str();
+}
+
+void output_cache::truncate(const std::string &path, const std::uint64_t size) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0)
+        throw_errno("open", path);
+
+    if (info.st_nlink > 1) {
+        const std::string temporary = path + "." + std::to_string(::getpid()) + ".tmp";
+        copy_file(path, temporary, std::min(size, std::uint64_t(info.st_size)));
+        if (::rename(temporary.c_str(), path.c_str()) != 0)
+            throw_errno("replace", path);
+    }
+    if (::truncate(path.c_str(), off_t(size)) != 0)
+        throw_errno("truncate", path);
+}
+
+#else
+
+output_cache::output_cache(const std::string &directory)
+    : _directory(directory) {
+    posix_required("output cache");
+}
+
+std::string output_cache::entry(const std::string &key) const {
+    return _directory + "/" + key;
+}
+
+std::uint64_t output_cache::cached_size(const std::string &) const {
+    return 0;
+}
+
+std::uint64_t output_cache::restore(const std::string &, const std::string &, std::uint64_t) {
+    return 0;
+}
+
+void output_cache::store(const std::string &, const std::string &, const std::string &) {}
+
+std::string output_cache::state(const std::string &) const {
+    return {};
+}
+
+void output_cache::truncate(const std::string &path, std::uint64_t) {
+    posix_required("resuming output " + path);
+}
+
+#endif
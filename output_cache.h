@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * Directory of generated outputs, each one under the hash of the canonical text of the config
+ * it was generated from (the count of vectors left out). The text is stored next to the output
+ * and compared, configs with the same hash do not mix. An output asked for as a whole is put in
+ * place by a hardlink, otherwise its first bytes are reflinked or copied, the generator then
+ * extends a shorter one and stores it again. The state of the streams after the output may be
+ * stored with it, an extension then goes on from the state.
+ *
+ * The outputs linked from the cache share the file with it, they have to be replaced instead of
+ * rewritten. The generator removes an output before writing it anew, and replaces a linked one
+ * by a copy before it extends it.
+ */
+
+#include <cstdint>
+#include <string>
+
+struct output_cache {
+    explicit output_cache(const std::string &directory);
+
+    /**
+     * Replaces the file at path by the first size bytes of the output cached under key, as many
+     * of them as there are. Returns the number of bytes put there, the file is removed anyway.
+     */
+    std::uint64_t restore(const std::string &key, const std::string &path, std::uint64_t size);
+
+    /**
+     * Stores the file at path as the output of key, unless the cached one is as long. The state
+     * is stored with it, an empty one removes the state stored before.
+     */
+    void store(const std::string &key, const std::string &path, const std::string &state);
+
+    /** State stored with the output of key, empty when there is none */
+    std::string state(const std::string &key) const;
+
+    /**
+     * Cuts the file at path to its first size bytes. A file linked elsewhere (an output restored
+     * from the cache) is replaced by a copy of them, the other links keep their bytes.
+     */
+    static void truncate(const std::string &path, std::uint64_t size);
+
+private:
+    // path of the entry of key, without an extension
+    std::string entry(const std::string &key) const;
+    // bytes cached under key, 0 when there is no entry of the key
+    std::uint64_t cached_size(const std::string &key) const;
+
+    const std::string _directory;
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+/**
+ * PCG32 (XSH RR 64/32) generators running side by side, one per SIMD lane. Each lane is an
+ * independent generator with its own state and sequence (increment), all of them seeded from
+ * a seed sequence. Round r of the generator gives the r-th output of every lane, the output
+ * words go lane after lane.
+ *
+ * The AVX2 variant is used when enabled at compile time (-mavx2 or -march=native), otherwise
+ * the lanes are plain arrays. Both give the very same output.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+struct pcg32_lanes {
+    static constexpr std::size_t lanes = 8;
+    static constexpr std::uint64_t multiplier = 6364136223846793005u;
+
+    /**
+     * Seeds every lane as pcg32(state, sequence) would, both taken from four words
+     * of the seed sequence.
+     */
+    template <typename SeedSeq> explicit pcg32_lanes(SeedSeq &&seq) {
+        std::uint32_t seeds[4 * lanes];
+        seq.generate(seeds, seeds + 4 * lanes);
+
+        for (std::size_t l = 0; l < lanes; ++l) {
+            const std::uint32_t *seed = seeds + 4 * l;
+            const std::uint64_t state = std::uint64_t(seed[1]) << 32 | seed[0];
+            const std::uint64_t sequence = std::uint64_t(seed[3]) << 32 | seed[2];
+            _increment[l] = sequence << 1 | 1;
+            _state[l] = (state + _increment[l]) * multiplier + _increment[l];
+        }
+    }
+
+    /**
+     * Fill size bytes with the output words (little endian), a started round is used
+     * only as far as it fits.
+     */
+    void fill(std::uint8_t *data, const std::size_t size) {
+        // the generators stay in local variables, the bytes written cannot alias them
+        registers generators = load();
+        std::uint32_t words[lanes];
+
+        for (std::size_t i = 0; i < size; i += sizeof(words)) {
+            next_round(generators, words);
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            if (size - i >= sizeof(words)) {
+                std::memcpy(data + i, words, sizeof(words));
+                continue;
+            }
+#endif
+            for (std::size_t j = 0; i + j < size && j < sizeof(words); ++j)
+                data[i + j] = std::uint8_t(words[j / 4] >> (8 * (j % 4)));
+        }
+        store(generators);
+    }
+
+private:
+#if defined(__AVX2__)
+    // lanes 0-3 and 4-7
+    struct registers {
+        __m256i state[2];
+        __m256i increment[2];
+    };
+
+    registers load() const {
+        registers generators;
+        for (std::size_t h = 0; h < 2; ++h) {
+            generators.state[h] =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_state + 4 * h));
+            generators.increment[h] =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(_increment + 4 * h));
+        }
+        return generators;
+    }
+
+    void store(const registers &generators) {
+        for (std::size_t h = 0; h < 2; ++h)
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(_state + 4 * h),
+                                generators.state[h]);
+    }
+
+    static void next_round(registers &generators, std::uint32_t *words) {
+        const __m256i low_multiplier = _mm256_set1_epi64x(std::int64_t(multiplier & 0xffffffff));
+        const __m256i high_multiplier = _mm256_set1_epi64x(std::int64_t(multiplier >> 32));
+        const __m256i low_half = _mm256_set1_epi64x(0xffffffff);
+        __m256i outputs[2];
+
+        for (std::size_t h = 0; h < 2; ++h) {
+            const __m256i state = generators.state[h];
+
+            // state * multiplier modulo 2^64 out of 32x32 bit products
+            const __m256i low = _mm256_mul_epu32(state, low_multiplier);
+            const __m256i cross =
+                _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(state, 32), low_multiplier),
+                                 _mm256_mul_epu32(state, high_multiplier));
+            const __m256i product = _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+            generators.state[h] = _mm256_add_epi64(product, generators.increment[h]);
+
+            // output of the previous state: xorshift high bits, then a random rotation
+            const __m256i shifted = _mm256_and_si256(
+                _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(state, 18), state), 27),
+                low_half);
+            const __m256i rotation = _mm256_srli_epi64(state, 59);
+            const __m256i left = _mm256_and_si256(
+                _mm256_sub_epi64(_mm256_set1_epi64x(32), rotation), _mm256_set1_epi64x(31));
+            outputs[h] = _mm256_and_si256(_mm256_or_si256(_mm256_srlv_epi64(shifted, rotation),
+                                                          _mm256_sllv_epi64(shifted, left)),
+                                          low_half);
+        }
+
+        // low words of both halves, in the order of the lanes
+        const __m256i first = _mm256_shuffle_epi32(outputs[0], _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256i second = _mm256_shuffle_epi32(outputs[1], _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256i mixed = _mm256_blend_epi32(first, second, 0xcc);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(words),
+                            _mm256_permute4x64_epi64(mixed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+#else
+    struct registers {
+        std::uint64_t state[lanes];
+        std::uint64_t increment[lanes];
+    };
+
+    registers load() const {
+        registers generators;
+        for (std::size_t l = 0; l < lanes; ++l) {
+            generators.state[l] = _state[l];
+            generators.increment[l] = _increment[l];
+        }
+        return generators;
+    }
+
+    void store(const registers &generators) {
+        for (std::size_t l = 0; l < lanes; ++l)
+            _state[l] = generators.state[l];
+    }
+
+    static void next_round(registers &generators, std::uint32_t *words) {
+        // independent lanes, the multiplications overlap even without vector instructions
+        for (std::size_t l = 0; l < lanes; ++l) {
+            const std::uint64_t state = generators.state[l];
+            generators.state[l] = state * multiplier + generators.increment[l];
+
+            const auto shifted = std::uint32_t(((state >> 18) ^ state) >> 27);
+            const auto rotation = std::uint32_t(state >> 59);
+            words[l] = shifted >> rotation | shifted << ((32 - rotation) & 31);
+        }
+    }
+#endif
+
+    std::uint64_t _state[lanes];
+    std::uint64_t _increment[lanes];
+};
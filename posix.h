@@ -0,0 +1,26 @@
+#pragma once
+
+/**
+ * Parts of POSIX shared by the output cache, the stream server and the ring in shared memory.
+ * Their code is compiled where CRYPTO_STREAMS_POSIX is defined, elsewhere it is replaced by stubs
+ * which throw posix_required.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CRYPTO_STREAMS_POSIX
+#endif
+
+/** Throws "cannot <action> <name>: " and the error of the system call failed last */
+[[noreturn]] inline void throw_errno(const std::string &action, const std::string &name) {
+    throw std::runtime_error("cannot " + action + " " + name + ": " + std::strerror(errno));
+}
+
+/** Throws from a stub of a feature on a system without POSIX */
+[[noreturn]] inline void posix_required(const std::string &feature) {
+    throw std::runtime_error(feature + " needs a POSIX system");
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * Constructors by name, one registry per family (stream types, hash functions, stream ciphers,
+ * block ciphers). A name is found by one lookup in a hash table instead of comparing it against
+ * every known name, and the names can be listed.
+ *
+ * A registry is either filled at once from a list of entries, or it is a function-local static
+ * filled by static registration objects spread over translation units, see registration.
+ */
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <typename Constructor> struct registry {
+    registry() = default;
+
+    registry(std::initializer_list<std::pair<const char *, Constructor>> entries) {
+        for (const auto &entry : entries)
+            add(entry.first, entry.second);
+    }
+
+    void add(const std::string &name, Constructor constructor) {
+        if (!_constructors.emplace(name, std::move(constructor)).second)
+            throw std::logic_error("name \"" + name + "\" is registered twice");
+    }
+
+    /** Constructor registered under the name, nullptr when there is none */
+    const Constructor *find(const std::string &name) const {
+        const auto it = _constructors.find(name);
+        return it == _constructors.end() ? nullptr : &it->second;
+    }
+
+    /** All registered names in alphabetical order */
+    std::vector<std::string> names() const {
+        std::vector<std::string> names;
+        names.reserve(_constructors.size());
+        for (const auto &entry : _constructors)
+            names.push_back(entry.first);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    /**
+     * Adds a constructor under one or more names when constructed, a static registration
+     * next to the code it constructs plugs it in without editing the lookup.
+     */
+    struct registration {
+        registration(registry &target,
+                     std::initializer_list<const char *> names,
+                     const Constructor &constructor) {
+            for (const char *name : names)
+                target.add(name, constructor);
+        }
+    };
+
+private:
+    std::unordered_map<std::string, Constructor> _constructors;
+};
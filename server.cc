@@ -0,0 +1,217 @@
+#include "server.h"
+#include "generator.h"
+#include "posix.h"
+
+#include <eacirc-core/json.h>
+#include <eacirc-core/logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#ifdef CRYPTO_STREAMS_POSIX
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// longest config a consumer may send, a line without an end is not read forever
+static const std::size_t max_request = std::size_t(1) << 20;
+
+/**
+ * Buffer of the bytes written to a connection, sent 64 KiB at a time. A write fails once the
+ * consumer has closed its end.
+ */
+struct socket_buffer : std::streambuf {
+    explicit socket_buffer(const int connection)
+        : _connection(connection)
+        , _buffer(std::size_t(1) << 16) {
+        setp(_buffer.data(), _buffer.data() + _buffer.size());
+    }
+
+    ~socket_buffer() override { send_all(); }
+
+protected:
+    int_type overflow(const int_type c) override {
+        if (!send_all())
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override { return send_all() ? 0 : -1; }
+
+private:
+    bool send_all() {
+        for (const char *data = pbase(); data < pptr();) {
+            const ssize_t sent = ::write(_connection, data, std::size_t(pptr() - data));
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent <= 0)
+                return false;
+            data += sent;
+        }
+        setp(_buffer.data(), _buffer.data() + _buffer.size());
+        return true;
+    }
+
+    const int _connection;
+    std::vector<char> _buffer;
+};
+
+// the config sent by the consumer, up to the end of its line; a consumer which does not send it
+// within the timeout does not hold the worker
+static std::string read_request(const int connection, const unsigned timeout) {
+    timeval limit = {};
+    limit.tv_sec = timeout;
+    if (::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit)) != 0)
+        throw std::runtime_error(std::string("cannot wait for the config: ") +
+                                 std::strerror(errno));
+
+    std::string request;
+    char chunk[4096];
+    for (;;) {
+        const ssize_t received = ::read(connection, chunk, sizeof(chunk));
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            throw std::runtime_error("config is not sent within " + std::to_string(timeout) +
+                                     " seconds");
+        if (received <= 0)
+            throw std::runtime_error("config does not end with a new line");
+
+        const char *end = std::find(chunk, chunk + received, '\n');
+        request.append(chunk, std::size_t(end - chunk));
+        if (end != chunk + received)
+            return request;
+        if (request.size() > max_request)
+            throw std::runtime_error("config is longer than 1 MiB");
+    }
+}
+
+stream_server::stream_server(const std::string &path, const unsigned request_timeout)
+    : _path(path)
+    , _request_timeout(request_timeout)
+    , _socket(-1)
+    , _stopped(false) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (_path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("socket path " + _path + " is too long");
+    std::copy(_path.begin(), _path.end(), address.sun_path);
+
+    // only a socket is replaced, a file at the path is an error of the user
+    struct stat info;
+    if (::stat(_path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+        ::unlink(_path.c_str());
+
+    _socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_socket == -1)
+        throw_errno("create socket", _path);
+    // the mode is set before anyone can connect, others must not make the server read files
+    if (::bind(_socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::chmod(_path.c_str(), 0600) != 0 || ::listen(_socket, SOMAXCONN) != 0) {
+        ::close(_socket);
+        throw_errno("listen on", _path);
+    }
+}
+
+stream_server::~stream_server() {
+    ::close(_socket);
+    ::unlink(_path.c_str());
+}
+
+void stream_server::run(const unsigned workers) {
+    // a consumer gone fails the write, it does not end the server
+    std::signal(SIGPIPE, SIG_IGN);
+    logger::info() << "serving streams on " << _path << std::endl;
+
+    // every worker waits for a connection of its own, the kernel hands each one to one of them
+    const auto work = [this] {
+        for (;;) {
+            const int connection = ::accept(_socket, nullptr, nullptr);
+            if (connection == -1) {
+                if (_stopped.load())
+                    return;
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                logger::error() << "cannot accept connections on " << _path << ": "
+                                << std::strerror(errno) << std::endl;
+                return;
+            }
+            serve(connection);
+            ::close(connection);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < workers; ++t)
+        threads.emplace_back(work);
+    work();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+void stream_server::stop() {
+    _stopped.store(true);
+    // wakes up the workers waiting in accept
+    ::shutdown(_socket, SHUT_RDWR);
+}
+
+void stream_server::serve(const int connection) const {
+    socket_buffer buffer(connection);
+    std::ostream out(&buffer);
+
+    std::unique_ptr<generator> stream_generator;
+    try {
+        json config = json::parse(read_request(connection, _request_timeout));
+        if (!config.count("tv_count"))
+            config["tv_count"] = std::numeric_limits<std::uint64_t>::max();
+        stream_generator = std::make_unique<generator>(config);
+        // rejected before "ok", the consumer would read an empty stream otherwise
+        stream_generator->require_single_output("stream");
+    } catch (std::exception &e) {
+        out << "error: " << e.what() << "\n" << std::flush;
+        return;
+    }
+
+    out << "ok\n";
+    try {
+        stream_generator->generate(out);
+    } catch (std::exception &e) {
+        // a consumer of an endless stream ends it by leaving, others see their stream end early
+        logger::info() << "stream served on " << _path << " ended: " << e.what() << std::endl;
+    }
+}
+
+#else
+
+stream_server::stream_server(const std::string &path, const unsigned request_timeout)
+    : _path(path)
+    , _request_timeout(request_timeout)
+    , _socket(-1)
+    , _stopped(false) {
+    posix_required("serving streams");
+}
+
+stream_server::~stream_server() {}
+
+void stream_server::run(unsigned) {}
+
+void stream_server::stop() {}
+
+void stream_server::serve(int) const {}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+/**
+ * Server generating the streams of configs for consumers on the same machine, over a Unix domain
+ * socket. The consumers read the bytes as they need them, no file is written.
+ *
+ * A consumer connects and sends a config (as given by -c) in JSON on one line. The server answers
+ * with a line, "ok" or "error: " and the reason, and after "ok" with the vectors of the stream,
+ * the same bytes the generator would write to the output file. The connection is closed after
+ * "tv_count" vectors, a config without the count gives an endless stream read until the consumer
+ * closes its end. The writes wait while the socket is full, a slow consumer holds back only its
+ * own stream. A config the server cannot stream (a sweep) is answered with an error, and so is
+ * a consumer which does not send its config within request_timeout seconds.
+ *
+ * The connections are served by a fixed set of workers, each of them builds the stream of one
+ * config at a time. The workers and the primitives set up in the process (registries, tables of
+ * the ciphers) stay for the next connections.
+ *
+ * Only the user running the server can connect to the socket, a config may read any file the
+ * server can read.
+ */
+
+#include <atomic>
+#include <string>
+
+struct stream_server {
+    /** Listens on a socket at path, a socket left there by a killed server is replaced */
+    explicit stream_server(const std::string &path, unsigned request_timeout = 10);
+    ~stream_server();
+
+    /** Serves the connections on workers threads, until the process is stopped or stop */
+    void run(unsigned workers);
+
+    /** Accepts no more connections, run returns once the workers serve none */
+    void stop();
+
+private:
+    void serve(int connection) const;
+
+    const std::string _path;
+    const unsigned _request_timeout;
+    int _socket;
+    std::atomic<bool> _stopped;
+};
@@ -0,0 +1,234 @@
+#include "shm_ring.h"
+#include "posix.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#ifdef CRYPTO_STREAMS_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// the slots start on a page of their own
+static const std::uint64_t data_offset = 4096;
+
+// waits of a side on the other one, the first are yields, the rest sleep longer and longer up to
+// a millisecond, a side waiting on a stalled one does not burn a core
+struct backoff {
+    std::uint64_t waited_ns = 0;
+
+    void wait() {
+        if (_rounds < 64) {
+            ++_rounds;
+            std::this_thread::yield();
+            return;
+        }
+        const timespec pause = {0, long(_sleep_ns)};
+        ::nanosleep(&pause, nullptr);
+        waited_ns += _sleep_ns;
+        _sleep_ns = std::min<std::uint64_t>(_sleep_ns * 2, 1000000);
+    }
+
+private:
+    unsigned _rounds = 0;
+    std::uint64_t _sleep_ns = 1000;
+};
+
+// a producer sets up its ring right after creating it, one that did not in this time is gone
+static const std::uint64_t setup_timeout_ns = 10000000000;
+
+static void *map(const int fd, const std::size_t size, const std::string &name) {
+    void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        throw_errno("map shared memory", name);
+    return mapping;
+}
+
+shm_ring::shm_ring(const std::string &name,
+                   const std::size_t vector_size,
+                   const std::uint64_t capacity,
+                   const std::uint64_t total)
+    : _name(name)
+    , _size(std::size_t(data_offset + capacity * vector_size))
+    , _header(nullptr)
+    , _data(nullptr) {
+    if (vector_size == 0 || capacity == 0)
+        throw std::runtime_error("ring " + _name + " needs a slot for vectors of a byte at least");
+
+    // a consumer still attached to an old ring keeps it, the new one is another object
+    ::shm_unlink(_name.c_str());
+    const int fd = ::shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1)
+        throw_errno("create shared memory", _name);
+    if (::ftruncate(fd, off_t(_size)) != 0) {
+        ::close(fd);
+        ::shm_unlink(_name.c_str());
+        throw_errno("allocate shared memory", _name);
+    }
+
+    void *mapping = map(fd, _size, _name);
+    _header = new (mapping) shm_ring_header;
+    _header->vector_size = vector_size;
+    _header->capacity = capacity;
+    _header->total = total;
+    _header->data_offset = data_offset;
+    _header->written.store(0, std::memory_order_relaxed);
+    _header->read.store(0, std::memory_order_relaxed);
+    _header->closed.store(0, std::memory_order_relaxed);
+    _data = static_cast<std::uint8_t *>(mapping) + data_offset;
+    // the consumer reads the rest of the header once it sees the magic
+    _header->magic.store(shm_ring_magic, std::memory_order_release);
+}
+
+shm_ring::~shm_ring() {
+    _header->closed.store(1, std::memory_order_release);
+    ::munmap(_header, _size);
+}
+
+std::uint64_t shm_ring::wait_free(const std::uint64_t max) {
+    const std::uint64_t capacity = _header->capacity;
+    const std::uint64_t written = _header->written.load(std::memory_order_relaxed);
+    std::uint64_t free;
+    // acquire, the consumer is done with the slots it has released
+    for (backoff pause;
+         (free = capacity - (written - _header->read.load(std::memory_order_acquire))) == 0;)
+        pause.wait();
+    return std::min(std::min(free, capacity - written % capacity), max);
+}
+
+std::uint8_t *shm_ring::slot(const std::uint64_t index) {
+    return _data + index % _header->capacity * _header->vector_size;
+}
+
+void shm_ring::publish(const std::uint64_t count) {
+    _header->written.store(_header->written.load(std::memory_order_relaxed) + count,
+                           std::memory_order_release);
+}
+
+shm_ring_reader::shm_ring_reader(const std::string &name)
+    : _size(0)
+    , _header(nullptr)
+    , _data(nullptr)
+    , _vector_size(0)
+    , _capacity(0) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+        throw_errno("open shared memory", name);
+
+    // the producer sizes the object right after creating it
+    struct stat info;
+    for (backoff pause;; pause.wait()) {
+        if (::fstat(fd, &info) != 0) {
+            const int error = errno;
+            ::close(fd);
+            errno = error;
+            throw_errno("inspect shared memory", name);
+        }
+        if (info.st_size != 0 || pause.waited_ns >= setup_timeout_ns)
+            break;
+    }
+    if (info.st_size < off_t(data_offset)) {
+        ::close(fd);
+        throw std::runtime_error("shared memory " + name + " is not a ring");
+    }
+
+    _size = std::size_t(info.st_size);
+    void *mapping = map(fd, _size, name);
+    _header = static_cast<shm_ring_header *>(mapping);
+    for (backoff pause; _header->magic.load(std::memory_order_acquire) != shm_ring_magic;) {
+        if (pause.waited_ns >= setup_timeout_ns) {
+            ::munmap(mapping, _size);
+            throw std::runtime_error("shared memory " + name + " is not a ring");
+        }
+        pause.wait();
+    }
+    // the slots are checked to lie in the mapping once, the reader uses its own copy of them
+    _vector_size = _header->vector_size;
+    _capacity = _header->capacity;
+    const std::uint64_t offset = _header->data_offset;
+    if (_vector_size == 0 || _capacity == 0 || offset < sizeof(shm_ring_header) ||
+        offset > _size || _capacity > (_size - offset) / _vector_size) {
+        ::munmap(mapping, _size);
+        throw std::runtime_error("slots of the ring " + name + " do not fit its shared memory");
+    }
+    _data = static_cast<const std::uint8_t *>(mapping) + offset;
+}
+
+shm_ring_reader::~shm_ring_reader() {
+    ::munmap(_header, _size);
+}
+
+std::uint64_t shm_ring_reader::wait_available(const std::uint64_t max) {
+    const std::uint64_t capacity = _capacity;
+    const std::uint64_t read = _header->read.load(std::memory_order_relaxed);
+    std::uint64_t written;
+    for (backoff pause; (written = _header->written.load(std::memory_order_acquire)) == read;) {
+        // the producer publishes its last vectors before it closes the ring
+        if (_header->closed.load(std::memory_order_acquire) &&
+            _header->written.load(std::memory_order_acquire) == read)
+            return 0;
+        pause.wait();
+    }
+    return std::min(std::min(written - read, capacity - read % capacity), max);
+}
+
+const std::uint8_t *shm_ring_reader::vector(const std::uint64_t index) const {
+    return _data + index % _capacity * _vector_size;
+}
+
+void shm_ring_reader::release(const std::uint64_t count) {
+    _header->read.store(_header->read.load(std::memory_order_relaxed) + count,
+                        std::memory_order_release);
+}
+
+#else
+
+shm_ring::shm_ring(const std::string &name, std::size_t, std::uint64_t, std::uint64_t)
+    : _name(name)
+    , _size(0)
+    , _header(nullptr)
+    , _data(nullptr) {
+    posix_required("ring in shared memory");
+}
+
+shm_ring::~shm_ring() {}
+
+std::uint64_t shm_ring::wait_free(std::uint64_t) {
+    return 0;
+}
+
+std::uint8_t *shm_ring::slot(std::uint64_t) {
+    return nullptr;
+}
+
+void shm_ring::publish(std::uint64_t) {}
+
+shm_ring_reader::shm_ring_reader(const std::string &)
+    : _size(0)
+    , _header(nullptr)
+    , _data(nullptr)
+    , _vector_size(0)
+    , _capacity(0) {
+    posix_required("ring in shared memory");
+}
+
+shm_ring_reader::~shm_ring_reader() {}
+
+std::uint64_t shm_ring_reader::wait_available(std::uint64_t) {
+    return 0;
+}
+
+const std::uint8_t *shm_ring_reader::vector(std::uint64_t) const {
+    return nullptr;
+}
+
+void shm_ring_reader::release(std::uint64_t) {}
+
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * Ring of vectors in a POSIX shared memory object, written by the generator and read in place by
+ * one consumer in another process. The consumer reads the vectors right from the mapping, and
+ * while the ring is neither full nor empty, neither side makes a system call.
+ *
+ * Layout of the object, native byte order, every index counts vectors from the first one:
+ *
+ *   offset    0  u64 magic        shm_ring_magic, stored last (release) when the ring is set up
+ *   offset    8  u64 vector_size  bytes of one vector
+ *   offset   16  u64 capacity     slots of the ring
+ *   offset   24  u64 total        vectors the producer writes in all
+ *   offset   32  u64 data_offset  offset of slot 0, the slots follow back to back
+ *   offset   64  u64 written      vectors published by the producer (atomic, release)
+ *   offset  128  u64 read         vectors released by the consumer (atomic, release)
+ *   offset  192  u32 closed       nonzero once the producer stops (atomic, release)
+ *
+ * Vector i is in slot i % capacity, at data_offset + (i % capacity) * vector_size. The consumer
+ * reads the vectors below written (acquire) and then stores read past them, the producer writes
+ * a slot only when written - read < capacity. A producer closed with written < total failed.
+ * The producer creates the object anew, readable by its user only, and leaves it when it ends,
+ * the consumer removes it with shm_unlink once it has read it. A side waiting on the other yields
+ * for a while and then sleeps up to a millisecond at a time. A producer stays blocked on a full
+ * ring while there is no consumer.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// the bytes "SCSRING1" in little endian
+static constexpr std::uint64_t shm_ring_magic = 0x31474e4952534353;
+
+struct shm_ring_header {
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t vector_size;
+    std::uint64_t capacity;
+    std::uint64_t total;
+    std::uint64_t data_offset;
+    // the indices on cache lines of their own, the two sides do not slow each other down
+    alignas(64) std::atomic<std::uint64_t> written;
+    alignas(64) std::atomic<std::uint64_t> read;
+    alignas(64) std::atomic<std::uint32_t> closed;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "indices shared between processes have to be lock free");
+
+/**
+ * Producer side of the ring: creates the object of the name (replacing one left there) for
+ * total vectors in capacity slots. The ring is closed when the producer is destroyed.
+ */
+struct shm_ring {
+    shm_ring(const std::string &name,
+             std::size_t vector_size,
+             std::uint64_t capacity,
+             std::uint64_t total);
+    ~shm_ring();
+
+    shm_ring(const shm_ring &) = delete;
+    shm_ring &operator=(const shm_ring &) = delete;
+
+    /**
+     * Waits for a free slot with no time limit, returns how many of the next slots can be written
+     * (at most max, they do not wrap around the end of the ring)
+     */
+    std::uint64_t wait_free(std::uint64_t max);
+
+    /** Slot of the vector of the index, the producer writes it while free */
+    std::uint8_t *slot(std::uint64_t index);
+
+    /** The next count slots are written, the consumer can read them */
+    void publish(std::uint64_t count);
+
+private:
+    const std::string _name;
+    std::size_t _size;
+    shm_ring_header *_header;
+    std::uint8_t *_data;
+};
+
+/**
+ * Consumer side of the ring, opens the object of the name once its producer has set it up, throws
+ * when it is not set up as a ring within 10 seconds or its slots do not fit in the object
+ */
+struct shm_ring_reader {
+    explicit shm_ring_reader(const std::string &name);
+    ~shm_ring_reader();
+
+    shm_ring_reader(const shm_ring_reader &) = delete;
+    shm_ring_reader &operator=(const shm_ring_reader &) = delete;
+
+    std::size_t vector_size() const { return std::size_t(_vector_size); }
+
+    /**
+     * Waits for a published vector, returns how many of the next ones can be read (at most
+     * max, they do not wrap around the end of the ring), 0 once the producer has closed the ring
+     */
+    std::uint64_t wait_available(std::uint64_t max);
+
+    /** The vector of the index, in place, while it is not released */
+    const std::uint8_t *vector(std::uint64_t index) const;
+
+    /** The next count vectors are read, the producer can write their slots */
+    void release(std::uint64_t count);
+
+private:
+    std::size_t _size;
+    shm_ring_header *_header;
+    const std::uint8_t *_data;
+    // the layout of the slots as checked when opened, the producer cannot change it afterwards
+    std::uint64_t _vector_size;
+    std::uint64_t _capacity;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * Bounded ring of vectors with a single producer and several consumers, every consumer reads
+ * every vector in order at its own cursor. Only the counters of the published and of the read
+ * vectors are shared, so the producer and the consumers can run on different threads without
+ * locks.
+ *
+ * A consumer keeps using the vector it has read last until it reads the next one, a slot is
+ * overwritten only when every consumer has moved past it. The producer is thus at most
+ * capacity - 1 vectors ahead of the slowest consumer, it sees the ring full before that.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+struct spmc_ring {
+    explicit spmc_ring(const std::size_t capacity)
+        : _capacity(capacity)
+        , _published(0) {
+        if (capacity < 2)
+            throw std::runtime_error("ring has to have at least 2 slots");
+    }
+
+    /**
+     * Adds a consumer, it starts at the oldest vector still kept. Consumers are added while
+     * nothing else uses the ring.
+     */
+    std::size_t add_consumer() {
+        const std::uint64_t published = _published.load(std::memory_order_relaxed);
+        _cursors.emplace_back();
+        _cursors.back().next.store(published < _capacity ? 0 : published - _capacity + 1,
+                                   std::memory_order_relaxed);
+        return _cursors.size() - 1;
+    }
+
+    /** The consumer does not read anymore, it does not hold the producer back */
+    void remove_consumer(const std::size_t consumer) {
+        _cursors[consumer].next.store(removed, std::memory_order_release);
+    }
+
+    /** Size of the vectors, set before the first one is published */
+    void resize(const std::size_t vector_size) {
+        _slots.assign(_capacity, std::vector<std::uint8_t>(vector_size));
+    }
+
+    std::size_t capacity() const { return _capacity; }
+
+    /** Producer: the slot of the next vector is still read by some consumer */
+    bool full() const {
+        const std::uint64_t next = _published.load(std::memory_order_relaxed);
+        for (const auto &cursor : _cursors) {
+            // acquire, the consumer is done with the slots it has moved past
+            const std::uint64_t read = cursor.next.load(std::memory_order_acquire);
+            if (read != removed && next >= read + _capacity - 1)
+                return true;
+        }
+        return false;
+    }
+
+    /** Producer: slot the next vector is written to, while the ring is not full */
+    std::vector<std::uint8_t> &slot() {
+        return _slots[std::size_t(_published.load(std::memory_order_relaxed) % _capacity)];
+    }
+
+    /** Producer: the slot is written, the consumers can read it */
+    void publish() {
+        _published.store(_published.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_release);
+    }
+
+    /** Consumer: the next vector of the consumer is published */
+    bool ready(const std::size_t consumer) const {
+        return _cursors[consumer].next.load(std::memory_order_relaxed) <
+               _published.load(std::memory_order_acquire);
+    }
+
+    /** Consumer: next vector of the consumer while ready, valid until it reads the next one */
+    const std::vector<std::uint8_t> &take(const std::size_t consumer) {
+        const std::uint64_t read = _cursors[consumer].next.load(std::memory_order_relaxed);
+        const std::vector<std::uint8_t> &vector = _slots[std::size_t(read % _capacity)];
+        _cursors[consumer].next.store(read + 1, std::memory_order_release);
+        return vector;
+    }
+
+private:
+    static constexpr std::uint64_t removed = std::numeric_limits<std::uint64_t>::max();
+
+    // every cursor on a cache line of its own, the consumers do not slow each other down
+    struct alignas(64) cursor {
+        std::atomic<std::uint64_t> next{0};
+    };
+
+    const std::size_t _capacity;
+    std::vector<std::vector<std::uint8_t>> _slots;
+    // written by the producer for every vector, away from what the consumers only read
+    alignas(64) std::atomic<std::uint64_t> _published;
+    alignas(64) std::deque<cursor> _cursors;
+};
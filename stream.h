@@ -4,6 +4,13 @@
 #include <eacirc-core/json.h>
 #include <eacirc-core/logger.h>
 #include <eacirc-core/view.h>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -11,11 +18,84 @@ using value_type = std::uint8_t;
 using vec_cview = view<std::vector<value_type>::const_iterator>;
 using vec_view = view<std::vector<value_type>::iterator>;
 
+/**
+ * Binary state of streams in checkpoints, it is read by the very same build only
+ */
+namespace stream_state {
+
+template <typename T> void write(std::ostream &out, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "written as raw memory");
+    out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> void read(std::istream &in, T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "read as raw memory");
+    if (!in.read(reinterpret_cast<char *>(&value), sizeof(value)))
+        throw std::runtime_error("state of a stream is cut short");
+}
+
+template <typename T> void write(std::ostream &out, const std::vector<T> &values) {
+    write(out, std::uint64_t(values.size()));
+    for (const T &value : values)
+        write(out, value);
+}
+
+template <typename T> void read(std::istream &in, std::vector<T> &values) {
+    std::uint64_t size;
+    read(in, size);
+    values.resize(std::size_t(size));
+    for (T &value : values)
+        read(in, value);
+}
+
+inline void write(std::ostream &out, const std::string &text) {
+    write(out, std::uint64_t(text.size()));
+    out.write(text.data(), std::streamsize(text.size()));
+}
+
+inline void read(std::istream &in, std::string &text) {
+    std::uint64_t size;
+    read(in, size);
+    text.resize(std::size_t(size));
+    if (!in.read(&text[0], std::streamsize(size)))
+        throw std::runtime_error("state of a stream is cut short");
+}
+
+/** Generators and distributions of the standard library (and pcg) print their whole state */
+template <typename T> void write_text(std::ostream &out, const T &value) {
+    std::ostringstream text;
+    text << value;
+    write(out, text.str());
+}
+
+template <typename T> void read_text(std::istream &in, T &value) {
+    std::string text;
+    read(in, text);
+    std::istringstream parsed(text);
+    if (!(parsed >> value))
+        throw std::runtime_error("state of a stream does not parse");
+}
+
+} // namespace stream_state
+
 struct stream {
     virtual ~stream() = default;
 
     virtual vec_cview next() = 0;
 
+    /**
+     * Writes the state the next vectors depend on. A stream built from the same config and seed
+     * gives the same vectors as this one once it loads the state. Streams whose state cannot be
+     * saved throw, as the default does.
+     */
+    virtual void save_state(std::ostream &) const {
+        throw std::runtime_error("stream cannot save its state");
+    }
+
+    virtual void load_state(std::istream &) {
+        throw std::runtime_error("stream cannot load its state");
+    }
+
     vec_cview get_data() const { return make_cview(_data); }
 
     void set_data(vec_cview data) { std::copy(data.begin(), data.end(), _data.begin()); }
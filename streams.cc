@@ -1,21 +1,183 @@
 #include "streams.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <unordered_set>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CRYPTO_STREAMS_MMAP
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CRYPTO_STREAMS_SSE2
+#endif
+
+rng_fill _to_rng_fill(const json &config) {
+    const int version = config.value("rng_version", 1);
+    if (version == 1)
+        return rng_fill::per_byte;
+    if (version == 2)
+        return rng_fill::whole_outputs;
+    throw std::runtime_error("rng_version " + std::to_string(version) + " does not exist");
+}
+
+_impl::alias_table::alias_table(const std::vector<double> &weights) {
+    const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+    if (weights.size() != 256 || !(total > 0))
+        throw std::runtime_error("distribution has no probability over the byte values");
+
+    // probabilities scaled so that a full column is 1, columns below and above it are paired
+    std::array<double, 256> scaled;
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    for (std::size_t i = 0; i < 256; ++i) {
+        scaled[i] = weights[i] / total * 256;
+        (scaled[i] < 1 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const std::size_t less = small.back();
+        const std::size_t more = large.back();
+        small.pop_back();
+        large.pop_back();
+
+        _threshold[less] = std::uint32_t(std::lround(std::ldexp(scaled[less], 24)));
+        _alias[less] = value_type(more);
+        scaled[more] -= 1 - scaled[less];
+        (scaled[more] < 1 ? small : large).push_back(more);
+    }
+    // what is left is a full column, up to rounding errors
+    for (const auto i : small)
+        _threshold[i] = 1 << 24;
+    for (const auto i : large)
+        _threshold[i] = 1 << 24;
+}
+
+double _impl::alias_table::probability(const value_type value) const {
+    std::uint64_t count = 0;
+    for (std::size_t i = 0; i < 256; ++i) {
+        if (i == value)
+            count += _threshold[i];
+        if (_alias[i] == value)
+            count += (1 << 24) - _threshold[i];
+    }
+    return std::ldexp(double(count), -32);
+}
 
 file_stream::file_stream(const json &config, const std::size_t osize)
     : stream(osize)
     , _path(config.at("path").get<std::string>())
-    , _istream(_path, std::ios::binary) {}
+    , _offset(config.value("offset", std::uint64_t(0)))
+    , _stride(config.value("stride", std::uint64_t(osize)))
+    , _limit(config.value("limit", std::numeric_limits<std::uint64_t>::max()))
+    , _loop(config.value("loop", false))
+    , _mapped(config.value("mmap", false))
+    , _index(0)
+    , _mapping(nullptr)
+    , _mapping_size(0) {
+    if (_stride == 0)
+        throw std::runtime_error("stride of file " + _path + " has to be positive");
+
+    if (!_mapped) {
+        _istream.open(_path, std::ios::binary);
+        _istream.seekg(std::streamoff(_offset));
+        return;
+    }
+
+#ifdef CRYPTO_STREAMS_MMAP
+    const int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("cannot open file " + _path + ": " + std::strerror(errno));
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        _mapping_size = std::size_t(info.st_size);
+        void *mapping = ::mmap(nullptr, _mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("cannot map file " + _path + ": " + std::strerror(errno));
+        }
+        ::madvise(mapping, _mapping_size, MADV_SEQUENTIAL);
+        _mapping = static_cast<const value_type *>(mapping);
+    }
+    ::close(fd); // the mapping stays valid, an empty file has none
+#else
+    throw std::runtime_error("mapping file " + _path + " to memory needs a POSIX system");
+#endif
+}
+
+file_stream::~file_stream() {
+#ifdef CRYPTO_STREAMS_MMAP
+    if (_mapping != nullptr)
+        ::munmap(const_cast<value_type *>(_mapping), _mapping_size);
+#endif
+}
+
+bool file_stream::read_mapped() {
+    const std::uint64_t position = _offset + _index * _stride;
+    if (_mapping_size < osize() || position > _mapping_size - osize())
+        return false;
+
+    std::copy_n(_mapping + position, osize(), _data.begin());
+    return true;
+}
+
+bool file_stream::read_file() {
+    // consecutive vectors follow one another, the others need a seek
+    if (_stride != osize())
+        _istream.seekg(std::streamoff(_offset + _index * _stride));
+    _istream.read(reinterpret_cast<char *>(_data.data()), std::streamsize(osize()));
+
+    if (_istream.bad()) {
+        perror("stream failbit (or badbit). error state:");
+        throw std::runtime_error("I/O error while reading a file " + _path);
+    }
+    return !_istream.fail();
+}
 
 vec_cview file_stream::next() {
-    _istream.read(reinterpret_cast<char *>(_data.data()), osize());
+    for (bool restarted = false;; restarted = true) {
+        if (_index < _limit && (_mapped ? read_mapped() : read_file())) {
+            ++_index;
+            return make_cview(_data);
+        }
+        if (!_loop || restarted || _index == 0)
+            break;
+
+        _index = 0;
+        if (!_mapped) {
+            _istream.clear();
+            _istream.seekg(std::streamoff(_offset));
+        }
+    }
 
-    if (_istream.fail()) {
+    if (!_mapped && !_istream.eof() && _index < _limit) {
         perror("stream failbit (or badbit). error state:");
         throw std::runtime_error("I/O error while reading a file " + _path);
     }
-    if (_istream.eof())
-        throw std::runtime_error("end of file " + _path + " reached, not enough data!");
+    throw std::runtime_error("end of file " + _path + " reached, not enough data!");
+}
 
-    return make_cview(_data);
+void file_stream::save_state(std::ostream &out) const {
+    stream_state::write(out, _index);
+}
+
+void file_stream::load_state(std::istream &in) {
+    stream_state::read(in, _index);
+    if (!_mapped) {
+        _istream.clear();
+        _istream.seekg(std::streamoff(_offset + _index * _stride));
+    }
 }
 
 single_value_stream::single_value_stream(
@@ -51,22 +213,107 @@ vec_cview repeating_stream::next() {
     return make_cview(_data);
 }
 
+void repeating_stream::save_state(std::ostream &out) const {
+    stream_state::write(out, _i);
+    stream_state::write(out, _data);
+    _source->save_state(out);
+}
+
+void repeating_stream::load_state(std::istream &in) {
+    stream_state::read(in, _i);
+    stream_state::read(in, _data);
+    _source->load_state(in);
+}
+
+static bool is_big_endian(const json &config) {
+    const std::string endianness = config.value("endianness", "little");
+    if (endianness == "little")
+        return false;
+    if (endianness == "big")
+        return true;
+    throw std::runtime_error("counter endianness \"" + endianness + "\" does not exist");
+}
+
 counter::counter(const std::size_t osize)
-    : stream(osize) {
+    : counter(json::object(), osize) {}
+
+counter::counter(const json &config, const std::size_t osize)
+    : stream(osize)
+    , _big_endian(is_big_endian(config))
+    , _step(config.value("step", std::uint64_t(1)))
+    , _limbs((osize + 7) / 8)
+    , _top_mask(osize % 8 == 0 ? ~std::uint64_t(0)
+                               : (std::uint64_t(1) << (8 * (osize % 8))) - 1) {
     std::fill(_data.begin(), _data.end(), std::numeric_limits<value_type>::min());
 }
 
-vec_cview counter::next() {
-    for (value_type &value : _data) {
-        if (value != std::numeric_limits<value_type>::max()) {
-            ++value;
-            break;
-        }
-        value = std::numeric_limits<value_type>::min();
+// limb 0 holds the least significant bytes, the last one may be shorter than 8 bytes
+std::uint64_t counter::load_limb(const value_type *value, const std::size_t i) const {
+    const std::size_t bytes = std::min<std::size_t>(8, osize() - 8 * i);
+    const value_type *first = _big_endian ? value + osize() - 8 * i - bytes : value + 8 * i;
+    std::uint64_t limb = 0;
+
+    if (bytes == 8) { // a fixed count lets the compiler do a single (byte swapped) load
+        for (std::size_t j = 0; j < 8; ++j)
+            limb |= std::uint64_t(first[_big_endian ? 7 - j : j]) << (8 * j);
+        return limb;
+    }
+    for (std::size_t j = 0; j < bytes; ++j)
+        limb |= std::uint64_t(first[_big_endian ? bytes - 1 - j : j]) << (8 * j);
+    return limb;
+}
+
+void counter::store_limb(value_type *value, const std::size_t i, const std::uint64_t limb) const {
+    const std::size_t bytes = std::min<std::size_t>(8, osize() - 8 * i);
+    value_type *first = _big_endian ? value + osize() - 8 * i - bytes : value + 8 * i;
+
+    if (bytes == 8) {
+        for (std::size_t j = 0; j < 8; ++j)
+            first[_big_endian ? 7 - j : j] = value_type(limb >> (8 * j));
+        return;
     }
+    for (std::size_t j = 0; j < bytes; ++j)
+        first[_big_endian ? bytes - 1 - j : j] = value_type(limb >> (8 * j));
+}
+
+void counter::increment(value_type *value) const {
+    std::uint64_t carry = _step;
+    for (std::size_t i = 0; i < _limbs && carry != 0; ++i) {
+        std::uint64_t limb = load_limb(value, i) + carry;
+        carry = limb < carry ? 1 : 0;
+        // the carry out of the most significant limb is dropped, the counter wraps around
+        if (i + 1 == _limbs)
+            limb &= _top_mask;
+        store_limb(value, i, limb);
+    }
+}
+
+vec_cview counter::next() {
+    increment(_data.data());
     return make_cview(_data);
 }
 
+void counter::next_batch(value_type *out, const std::size_t count) {
+    const value_type *previous = _data.data();
+
+    for (std::size_t i = 0; i < count; ++i) {
+        value_type *value = out + i * osize();
+        std::copy_n(previous, osize(), value);
+        increment(value);
+        previous = value;
+    }
+    if (count != 0)
+        std::copy_n(previous, osize(), _data.begin());
+}
+
+void counter::save_state(std::ostream &out) const {
+    stream_state::write(out, _data);
+}
+
+void counter::load_state(std::istream &in) {
+    stream_state::read(in, _data);
+}
+
 random_start_counter::random_start_counter(default_seed_source &seeder, const std::size_t osize)
     : counter(osize) {
     auto stream = std::make_unique<pcg32_stream>(seeder, osize);
@@ -74,6 +321,166 @@ random_start_counter::random_start_counter(default_seed_source &seeder, const st
     std::copy(single_vector.begin(), single_vector.end(), _data.begin());
 }
 
+#if defined(__AVX2__)
+
+using simd_chunk = __m256i;
+
+static simd_chunk load_chunk(const value_type *data) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+}
+
+static void store_chunk(value_type *data, const simd_chunk chunk) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(data), chunk);
+}
+
+static simd_chunk combine_chunk(const combine_operation operation, simd_chunk a, simd_chunk b) {
+    switch (operation) {
+    case combine_operation::bitwise_xor:
+        return _mm256_xor_si256(a, b);
+    case combine_operation::bitwise_and:
+        return _mm256_and_si256(a, b);
+    case combine_operation::bitwise_or:
+        return _mm256_or_si256(a, b);
+    case combine_operation::add8:
+        return _mm256_add_epi8(a, b);
+    case combine_operation::add16:
+        return _mm256_add_epi16(a, b);
+    case combine_operation::add32:
+        return _mm256_add_epi32(a, b);
+    case combine_operation::add64:
+        return _mm256_add_epi64(a, b);
+    }
+    return a;
+}
+
+#elif defined(CRYPTO_STREAMS_SSE2)
+
+// two SSE2 registers make one chunk of 32 bytes
+struct simd_chunk {
+    __m128i low;
+    __m128i high;
+};
+
+static simd_chunk load_chunk(const value_type *data) {
+    return {_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16))};
+}
+
+static void store_chunk(value_type *data, const simd_chunk chunk) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data), chunk.low);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data + 16), chunk.high);
+}
+
+static __m128i combine_half(const combine_operation operation, __m128i a, __m128i b) {
+    switch (operation) {
+    case combine_operation::bitwise_xor:
+        return _mm_xor_si128(a, b);
+    case combine_operation::bitwise_and:
+        return _mm_and_si128(a, b);
+    case combine_operation::bitwise_or:
+        return _mm_or_si128(a, b);
+    case combine_operation::add8:
+        return _mm_add_epi8(a, b);
+    case combine_operation::add16:
+        return _mm_add_epi16(a, b);
+    case combine_operation::add32:
+        return _mm_add_epi32(a, b);
+    case combine_operation::add64:
+        return _mm_add_epi64(a, b);
+    }
+    return a;
+}
+
+static simd_chunk combine_chunk(const combine_operation operation, simd_chunk a, simd_chunk b) {
+    return {combine_half(operation, a.low, b.low), combine_half(operation, a.high, b.high)};
+}
+
+#endif
+
+// bytes of one word of the addition, 0 for the bitwise operations
+static std::size_t word_size(const combine_operation operation) {
+    switch (operation) {
+    case combine_operation::add8:
+        return 1;
+    case combine_operation::add16:
+        return 2;
+    case combine_operation::add32:
+        return 4;
+    case combine_operation::add64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+#if defined(__AVX2__) || defined(CRYPTO_STREAMS_SSE2)
+// the operation is a template argument, so the switch of combine_chunk folds away in the loop
+template <combine_operation Operation>
+static std::size_t combine_chunks(value_type *out, const value_type *in, const std::size_t size) {
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+        store_chunk(out + i, combine_chunk(Operation, load_chunk(out + i), load_chunk(in + i)));
+    return i;
+}
+
+static std::size_t combine_chunks(value_type *out,
+                                  const value_type *in,
+                                  const std::size_t size,
+                                  const combine_operation operation) {
+    switch (operation) {
+    case combine_operation::bitwise_xor:
+        return combine_chunks<combine_operation::bitwise_xor>(out, in, size);
+    case combine_operation::bitwise_and:
+        return combine_chunks<combine_operation::bitwise_and>(out, in, size);
+    case combine_operation::bitwise_or:
+        return combine_chunks<combine_operation::bitwise_or>(out, in, size);
+    case combine_operation::add8:
+        return combine_chunks<combine_operation::add8>(out, in, size);
+    case combine_operation::add16:
+        return combine_chunks<combine_operation::add16>(out, in, size);
+    case combine_operation::add32:
+        return combine_chunks<combine_operation::add32>(out, in, size);
+    case combine_operation::add64:
+        return combine_chunks<combine_operation::add64>(out, in, size);
+    }
+    return 0;
+}
+#endif
+
+void combine_bytes(value_type *out,
+                   const value_type *in,
+                   const std::size_t size,
+                   const combine_operation operation) {
+    std::size_t i = 0;
+
+#if defined(__AVX2__) || defined(CRYPTO_STREAMS_SSE2)
+    i = combine_chunks(out, in, size, operation);
+#endif
+
+    // the rest byte by byte, the chunks end at word boundaries
+    const std::size_t word = word_size(operation);
+    unsigned carry = 0;
+    for (; i < size; ++i) {
+        switch (operation) {
+        case combine_operation::bitwise_xor:
+            out[i] ^= in[i];
+            break;
+        case combine_operation::bitwise_and:
+            out[i] &= in[i];
+            break;
+        case combine_operation::bitwise_or:
+            out[i] |= in[i];
+            break;
+        default:
+            if (i % word == 0)
+                carry = 0;
+            carry += unsigned(out[i]) + in[i];
+            out[i] = value_type(carry);
+            carry >>= 8;
+        }
+    }
+}
+
 template <typename Seeder>
 xor_stream::xor_stream(
     const json &config,
@@ -85,39 +492,311 @@ xor_stream::xor_stream(
 
 vec_cview xor_stream::next() {
     vec_cview in = _source->next();
-    auto first1 = in.begin();
-    const auto last = in.begin() + _data.size();
-    auto first2 = in.begin() + _data.size();
-    auto o_first = _data.begin();
+    std::copy_n(in.begin(), _data.size(), _data.begin());
+    combine_bytes(_data.data(),
+                  &(*(in.begin() + std::ptrdiff_t(_data.size()))),
+                  _data.size(),
+                  combine_operation::bitwise_xor);
 
-    while (first1 != last) {
-        *o_first++ = (*first1++ xor *first2++);
+    return make_cview(_data);
+}
+
+void xor_stream::save_state(std::ostream &out) const {
+    _source->save_state(out);
+}
+
+void xor_stream::load_state(std::istream &in) {
+    _source->load_state(in);
+}
+
+combine_operation _to_combine_operation(const std::string &name) {
+    if (name == "xor")
+        return combine_operation::bitwise_xor;
+    if (name == "and")
+        return combine_operation::bitwise_and;
+    if (name == "or")
+        return combine_operation::bitwise_or;
+    if (name == "add8")
+        return combine_operation::add8;
+    if (name == "add16")
+        return combine_operation::add16;
+    if (name == "add32")
+        return combine_operation::add32;
+    if (name == "add64")
+        return combine_operation::add64;
+    throw std::runtime_error("requested combine operation named \"" + name +
+                             "\" does not exist");
+}
+
+combine_stream::combine_stream(
+    const json &config,
+    default_seed_source &seeder,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+    const std::size_t osize)
+    : stream(osize)
+    , _operation(_to_combine_operation(config.value("operation", "xor")))
+    , _segments(config.count("sources") ? 1 : std::size_t(config.value("segments", 2))) {
+    if (config.count("sources")) {
+        for (const auto &source : config.at("sources"))
+            _sources.push_back(make_stream(source, seeder, pipes, osize));
+    } else {
+        _sources.push_back(make_stream(config.at("source"), seeder, pipes, osize * _segments));
     }
 
+    if (_sources.size() * _segments < 1)
+        throw std::runtime_error("combine stream needs at least one input");
+}
+
+vec_cview combine_stream::next() {
+    bool first = true;
+    for (const auto &source : _sources) {
+        vec_cview in = source->next();
+        for (std::size_t s = 0; s < _segments; ++s) {
+            const value_type *segment = &(*in.begin()) + s * osize();
+            if (first)
+                std::copy_n(segment, osize(), _data.begin());
+            else
+                combine_bytes(_data.data(), segment, osize(), _operation);
+            first = false;
+        }
+    }
     return make_cview(_data);
 }
 
+void combine_stream::save_state(std::ostream &out) const {
+    for (const auto &source : _sources)
+        source->save_state(out);
+}
+
+void combine_stream::load_state(std::istream &in) {
+    for (auto &source : _sources)
+        source->load_state(in);
+}
+
+// binomial coefficient, saturated at the maximum of std::uint64_t
+static std::uint64_t binomial(const std::size_t n, std::size_t k) {
+    const std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+    if (k > n)
+        return 0;
+    k = std::min(k, n - k);
+
+    std::uint64_t result = 1;
+    for (std::size_t j = 1; j <= k; ++j) {
+        // result * factor / j is exact, split it so the product cannot overflow first
+        const std::uint64_t factor = n - k + j;
+        const std::uint64_t quotient = result / j;
+        const std::uint64_t rest = result % j * factor / j;
+        if (quotient > (max - rest) / factor)
+            return max;
+        result = quotient * factor + rest;
+    }
+    return result;
+}
+
+// bit i of the result is bit 63 - i of x
+static std::uint64_t reverse_bits(std::uint64_t x) {
+    x = (x >> 1 & 0x5555555555555555) | (x & 0x5555555555555555) << 1;
+    x = (x >> 2 & 0x3333333333333333) | (x & 0x3333333333333333) << 2;
+    x = (x >> 4 & 0x0f0f0f0f0f0f0f0f) | (x & 0x0f0f0f0f0f0f0f0f) << 4;
+    x = (x >> 8 & 0x00ff00ff00ff00ff) | (x & 0x00ff00ff00ff00ff) << 8;
+    x = (x >> 16 & 0x0000ffff0000ffff) | (x & 0x0000ffff0000ffff) << 16;
+    return x >> 32 | x << 32;
+}
+
+// lowest n bits set
+static std::uint64_t low_bits(const std::size_t n) {
+    return n >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1;
+}
+
 vec_cview hw_counter::next() {
-    std::copy_n(_origin_data.begin(), osize(), _data.begin());
-    for (const auto &pos : _cur_positions) {
-        _data[pos / 8] ^= (1 << (pos % 8));
+    if (_advance && !combination_next()) {
+        overflow();
+        combination_init(0);
     }
+    _advance = true;
+
+    return make_cview(_data);
+}
 
-    if (!combination_next()) {
-        if (_increase_hw) {
-            _cur_hw += 1;
-        } else if (_randomize_overflow) {
-            randomize(); // combination space depleted && not increasing HW.
+void hw_counter::save_state(std::ostream &out) const {
+    stream_state::write_text(out, _rng);
+    stream_state::write(out, _origin_data);
+    stream_state::write(out, _cur_hw);
+    stream_state::write(out, _cur_positions);
+    stream_state::write(out, _word);
+    stream_state::write(out, _last_word);
+    stream_state::write(out, _advance);
+    stream_state::write(out, _data);
+}
+
+void hw_counter::load_state(std::istream &in) {
+    stream_state::read_text(in, _rng);
+    stream_state::read(in, _origin_data);
+    stream_state::read(in, _cur_hw);
+    stream_state::read(in, _cur_positions);
+    stream_state::read(in, _word);
+    stream_state::read(in, _last_word);
+    stream_state::read(in, _advance);
+    stream_state::read(in, _data);
+}
+
+void hw_counter::seek(std::uint64_t index) {
+    const std::size_t bits = osize() * 8;
+    _rng = _start_rng;
+    _origin_data = _start_origin_data;
+    _cur_hw = _start_hw;
+
+    for (std::uint64_t count = binomial(bits, _cur_hw);
+         index >= count && count != std::numeric_limits<std::uint64_t>::max();
+         count = binomial(bits, _cur_hw)) {
+        if (!_increase_hw && !_randomize_overflow) {
+            index %= count; // the same combinations over and over
+            break;
         }
+        index -= count;
+        overflow();
+        // from weight 1, all weights together are all the 2^bits - 1 nonzero vectors
+        if (_increase_hw && _cur_hw == 1 && bits < 64)
+            index %= low_bits(bits);
+    }
+
+    combination_init(index);
+    _advance = false;
+}
+
+void hw_counter::overflow() {
+    if (_increase_hw) {
+        _cur_hw += 1;
+    } else if (_randomize_overflow) {
+        randomize(); // combination space depleted && not increasing HW.
+    }
+
+    if (_cur_hw > osize() * 8 && _increase_hw) {
+        _cur_hw = 1; // reset
+    }
+}
+
+// rank-th combination in lexicographic order, positions before p are skipped together with
+// the binomial(bits - 1 - p, rest) combinations that start by p
+void hw_counter::combination_init(std::uint64_t rank) {
+    const std::size_t bits = osize() * 8;
+
+    _cur_positions.clear();
+    for (std::size_t p = 0; _cur_positions.size() < _cur_hw; ++p) {
+        const std::uint64_t count = binomial(bits - 1 - p, _cur_hw - 1 - _cur_positions.size());
+        if (rank < count)
+            _cur_positions.push_back(p);
+        else
+            rank -= count;
+    }
+
+    if (bits <= 64) {
+        std::uint64_t reversed = 0;
+        for (const auto &pos : _cur_positions)
+            reversed |= std::uint64_t(1) << (bits - 1 - pos);
+        _word = ~reversed & low_bits(bits);
+        _last_word = low_bits(bits) & ~low_bits(_cur_hw);
+        write_word();
+        return;
+    }
 
-        if (_cur_hw > osize() * 8 && _increase_hw) {
-            _cur_hw = 1; // reset
+    std::copy_n(_origin_data.begin(), osize(), _data.begin());
+    for (const auto &pos : _cur_positions)
+        flip(pos);
+}
+
+bool hw_counter::combination_next() {
+    if (osize() * 8 <= 64) {
+        if (_word == _last_word)
+            return false;
+
+        // Gosper's hack, the next larger word with the same number of set bits
+        const std::uint64_t lowest = _word & (~_word + 1);
+        const std::uint64_t ripple = _word + lowest;
+        _word = (((ripple ^ _word) >> 2) / lowest) | ripple;
+        write_word();
+        return true;
+    }
+
+    const auto size = static_cast<int64_t>(_cur_positions.size());
+    auto idx = size - 1;
+
+    if (_cur_positions[idx] == osize() * 8 - 1) {
+        do {
+            idx -= 1;
+        } while (idx >= 0 && _cur_positions[idx] + 1 == _cur_positions[idx + 1]);
+
+        if (idx < 0) {
+            return false;
         }
+    }
 
-        combination_init();
+    // only the positions from idx on move, flip them back and forth in place
+    for (auto j = idx; j < size; ++j) {
+        flip(_cur_positions[j]);
+    }
+    for (auto j = idx + 1; j < size; ++j) {
+        _cur_positions[j] = _cur_positions[idx] + j - idx + 1;
     }
+    _cur_positions[idx]++;
+    for (auto j = idx; j < size; ++j) {
+        flip(_cur_positions[j]);
+    }
+    return true;
+}
 
-    return make_cview(_data);
+void hw_counter::write_word() {
+    const std::size_t bits = osize() * 8;
+    const std::uint64_t positions = reverse_bits(~_word & low_bits(bits)) >> (64 - bits);
+
+    for (std::size_t i = 0; i < osize(); ++i)
+        _data[i] = _origin_data[i] ^ value_type(positions >> (8 * i));
+}
+
+/**
+ * Transpose the 8x8 bit matrix of 8 bytes, bits taken from the most significant one: bit c of
+ * byte r (the most significant byte of x is byte 0) becomes bit r of byte c.
+ */
+static std::uint64_t transpose_8x8(std::uint64_t x) {
+    std::uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+// 8x8 bit block of byte b of 8 rows, as taken by transpose_8x8
+static std::uint64_t
+gather_8x8(const value_type *rows, const std::size_t row_bytes, std::size_t b) {
+    std::uint64_t x = 0;
+    for (std::size_t r = 0; r < 8; ++r)
+        x = x << 8 | rows[r * row_bytes + b];
+    return x;
+}
+
+/**
+ * Bit matrix transposition in 8x8 blocks. Row i of rows (row_bytes each) becomes bit i of
+ * every column, column j of the result (rows / 8 bytes) is bit j of every row. Bits are
+ * counted from the most significant one of a byte in both directions.
+ */
+static void transpose_bits(const value_type *rows,
+                           const std::size_t row_bytes,
+                           const std::size_t row_count,
+                           value_type *columns) {
+    const std::size_t column_bytes = row_count / 8;
+
+    for (std::size_t k = 0; k < column_bytes; ++k) {
+        const value_type *block = rows + 8 * k * row_bytes;
+
+        for (std::size_t b = 0; b < row_bytes; ++b) {
+            const std::uint64_t x = transpose_8x8(gather_8x8(block, row_bytes, b));
+            for (std::size_t c = 0; c < 8; ++c)
+                columns[(8 * b + c) * column_bytes + k] = value_type(x >> (56 - 8 * c));
+        }
+    }
 }
 
 column_stream::column_stream(
@@ -127,37 +806,39 @@ column_stream::column_stream(
     const std::size_t osize)
     : stream(osize)
     , _internal_bit_size(std::size_t(config.at("size")) * 8)
-    , _buf(_internal_bit_size)
+    , _rows(osize * _internal_bit_size)
+    , _buf(osize * _internal_bit_size)
     , _position(0)
-    , _source(make_stream(config.at("source"), seeder, pipes, _internal_bit_size / 8)) {
-    for (auto &v : _buf)
-        v.resize(osize);
-}
+    , _source(make_stream(config.at("source"), seeder, pipes, _internal_bit_size / 8)) {}
 
 vec_cview column_stream::next() {
     // regenerate the buffer
     if ((_position % _internal_bit_size) == 0) {
         _position = 0;
 
-        // memset _buf to 0; change to STL?
-        for (auto &vec : _buf)
-            for (auto &val : vec)
-                val = 0;
-
+        const std::size_t row_bytes = _internal_bit_size / 8;
         for (std::size_t i = 0; i < osize() * 8; ++i) {
-            auto vec = _source->next().data();
-
-            // something like matrix transposition
-            for (std::size_t j = 0; j < _internal_bit_size; ++j) {
-                // select current bit (&), move it as least significant (>>) and then move it to the
-                // position given by _i_ - which column you should store to
-                _buf[j][i / 8] |= ((vec[j / 8] & (0x1 << (7 - (j % 8)))) >> (7 - (j % 8)))
-                                  << (7 - (i % 8));
-            }
+            vec_cview vec = _source->next();
+            std::copy_n(vec.begin(), row_bytes, _rows.begin() + std::ptrdiff_t(i * row_bytes));
         }
+
+        // column j of the source vectors is output vector j
+        transpose_bits(_rows.data(), row_bytes, osize() * 8, _buf.data());
     }
 
-    return make_cview(_buf[_position++]); // return and increment
+    return make_view(_buf.cbegin() + std::ptrdiff_t(osize() * _position++), osize());
+}
+
+void column_stream::save_state(std::ostream &out) const {
+    stream_state::write(out, _buf);
+    stream_state::write(out, _position);
+    _source->save_state(out);
+}
+
+void column_stream::load_state(std::istream &in) {
+    stream_state::read(in, _buf);
+    stream_state::read(in, _position);
+    _source->load_state(in);
 }
 
 column_fixed_position_stream::column_fixed_position_stream(
@@ -165,49 +846,512 @@ column_fixed_position_stream::column_fixed_position_stream(
     default_seed_source &seeder,
     std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
     const std::size_t osize,
-    const std::size_t position)
+    std::vector<std::size_t> positions)
     : stream(osize)
-    , _position(position)
-    , _source(make_stream(config.at("source"), seeder, pipes, std::size_t(config.at("size")))) {}
+    , _size(std::size_t(config.at("size")))
+    , _positions(std::move(positions))
+    , _rows(osize * 8 * _size)
+    , _buf(osize * _positions.size())
+    , _i(0)
+    , _source(make_stream(config.at("source"), seeder, pipes, _size)) {
+    if (_positions.empty())
+        throw std::runtime_error("column_fixed_position stream needs at least one position");
+
+    // group the requested bits by their source byte, each byte is transposed once
+    std::map<std::size_t, std::vector<std::pair<std::size_t, std::size_t>>> bytes;
+    for (std::size_t slot = 0; slot < _positions.size(); ++slot) {
+        const std::size_t position = _positions[slot];
+        if (position >= _size * 8)
+            throw std::runtime_error("column position " + std::to_string(position) +
+                                     " is out of the source vector of " +
+                                     std::to_string(_size) + " bytes");
+        bytes[position / 8].emplace_back(position % 8, slot);
+    }
+    _bytes.assign(bytes.begin(), bytes.end());
+}
 
 vec_cview column_fixed_position_stream::next() {
-    for (auto &val : _data)
-        val = 0;
+    // one batch of source vectors gives the columns of all positions
+    if (_i == 0) {
+        for (std::size_t i = 0; i < osize() * 8; ++i) {
+            vec_cview vec = _source->next();
+            std::copy_n(vec.begin(), _size, _rows.begin() + std::ptrdiff_t(i * _size));
+        }
 
-    std::size_t rev_pos = 7 - (_position % 8);
+        for (std::size_t k = 0; k < osize(); ++k) {
+            const value_type *block = _rows.data() + 8 * k * _size;
 
-    for (std::size_t i = 0; i < osize() * 8; ++i) {
-        auto vec = _source->next().data();
+            for (const auto &byte : _bytes) {
+                const std::uint64_t x = transpose_8x8(gather_8x8(block, _size, byte.first));
+                for (const auto &bit : byte.second)
+                    _buf[bit.second * osize() + k] = value_type(x >> (56 - 8 * bit.first));
+            }
+        }
+    }
+
+    auto column = make_view(_buf.cbegin() + std::ptrdiff_t(osize() * _i), osize());
+    _i = (_i + 1) % _positions.size();
+    return column;
+}
+
+void column_fixed_position_stream::save_state(std::ostream &out) const {
+    stream_state::write(out, _buf);
+    stream_state::write(out, _i);
+    _source->save_state(out);
+}
+
+void column_fixed_position_stream::load_state(std::istream &in) {
+    stream_state::read(in, _buf);
+    stream_state::read(in, _i);
+    _source->load_state(in);
+}
 
-        std::size_t rev_i = 7 - (i % 8);
-        _data[i / 8] += ((vec[_position / 8] & (0x1 << rev_pos)) >> rev_pos) << rev_i;
+namespace _impl {
+
+pipe::pipe(const std::string &id)
+    : stream(0)
+    , _id(id)
+    , _pending_consumers(0)
+    , _producing(false)
+    , _concurrent(false)
+    , _stop(false)
+    , _failed(false)
+    , _waiting(0) {}
+
+pipe::~pipe() {
+    if (_producer.joinable()) {
+        _stop.store(true, std::memory_order_release);
+        wake();
+        _producer.join();
     }
+}
+
+// rounds a side checks the ring before it sleeps, the other one is usually quick to move
+static const unsigned spin_limit = 64;
 
-    return make_cview(_data); // return and increment
+template <typename Condition> void pipe::wait(Condition condition) {
+    for (unsigned spin = 0; spin < spin_limit; ++spin) {
+        if (condition())
+            return;
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(_wait_mutex);
+    _waiting.fetch_add(1);
+    // with the fence of wake, either the condition holds here or the other side sees the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _changed.wait(lock, condition);
+    _waiting.fetch_sub(1);
 }
 
+void pipe::wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waiting.load(std::memory_order_relaxed) == 0)
+        return;
+    // under the lock, a waiter cannot be between its check and its sleep
+    std::lock_guard<std::mutex> lock(_wait_mutex);
+    _changed.notify_all();
+}
+
+void pipe::set_source(std::unique_ptr<stream> source,
+                      const std::size_t capacity,
+                      const bool concurrent) {
+    if (_source)
+        throw std::runtime_error("pipe \"" + _id + "\" has more than one pipe_in_stream");
+
+    _source = std::move(source);
+    _concurrent = concurrent;
+    _ring = std::make_unique<spmc_ring>(capacity);
+    _ring->resize(_source->osize());
+    _initial.assign(_source->osize(), 0);
+    for (; _pending_consumers > 0; --_pending_consumers)
+        _ring->add_consumer();
+}
+
+std::size_t pipe::add_consumer() {
+    if (!_ring)
+        return _pending_consumers++;
+    if (_producer.joinable())
+        throw std::runtime_error("pipe \"" + _id +
+                                 "\" is read by a new pipe stream after its thread started");
+    return _ring->add_consumer();
+}
+
+void pipe::remove_consumer(const std::size_t consumer) {
+    if (_ring)
+        _ring->remove_consumer(consumer);
+    // the thread may wait for the consumer
+    if (_concurrent)
+        wake();
+}
+
+void pipe::produce() {
+    _producing = true;
+    vec_cview view = _source->next();
+    std::copy(view.begin(), view.end(), _ring->slot().begin());
+    _ring->publish();
+    _producing = false;
+}
+
+void pipe::run() {
+    const auto writable = [this] {
+        return !_ring->full() || _stop.load(std::memory_order_acquire);
+    };
+    try {
+        for (;;) {
+            wait(writable);
+            if (_stop.load(std::memory_order_acquire))
+                return;
+            produce();
+            wake();
+        }
+    } catch (...) {
+        // the pipe streams rethrow it when they run out of vectors
+        _error = std::current_exception();
+        _failed.store(true, std::memory_order_release);
+        wake();
+    }
+}
+
+vec_cview pipe::next(const std::size_t consumer) {
+    if (!_source)
+        throw std::runtime_error("pipe \"" + _id + "\" has no pipe_in_stream");
+
+    // the thread starts with the first read, when all the pipe streams are built
+    if (_concurrent) {
+        std::call_once(_started, [this] { _producer = std::thread(&pipe::run, this); });
+
+        wait([this, consumer] {
+            return _ring->ready(consumer) || _failed.load(std::memory_order_acquire);
+        });
+        if (!_ring->ready(consumer))
+            std::rethrow_exception(_error);
+        vec_cview vector = make_cview(_ring->take(consumer));
+        // the slot before the vector is free now
+        wake();
+        return vector;
+    }
+
+    while (!_ring->ready(consumer)) {
+        // a pipe stream in the source of its own pipe (a feedback loop) reads one vector behind,
+        // the very first time it gets zeros
+        if (_producing)
+            return make_cview(_initial);
+        // nobody else runs the source on this thread, a full ring would never empty
+        if (_ring->full())
+            throw std::runtime_error("pipe \"" + _id + "\" is read more than " +
+                                     std::to_string(_ring->capacity() - 1) +
+                                     " vectors ahead of one of its pipe streams");
+        produce();
+    }
+    return make_cview(_ring->take(consumer));
+}
+
+std::shared_ptr<std::unique_ptr<stream>>
+find_pipe(std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+          const std::string &id) {
+    // the first pipe stream of the id creates the pipe, in or out
+    auto &entry = pipes[id];
+    if (!entry)
+        entry = std::make_shared<std::unique_ptr<stream>>(std::make_unique<pipe>(id));
+    return entry;
+}
+
+} // namespace _impl
+
 pipe_in_stream::pipe_in_stream(
     const nlohmann::json &config,
     default_seed_source &seeder,
     std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
     const std::size_t osize)
     : stream(0) {
-    std::string pipe_id = config.at("id");
+    const std::string pipe_id = config.at("id");
+    const bool concurrent = config.value("concurrent", false);
 
-    // substream has to be created in advance
-    // creating it separately in following if would cause inconsistances
-    std::unique_ptr<stream> new_stream = make_stream(config.at("source"), seeder, pipes, osize);
+    // substream has to be created in advance, it may create pipes of its own
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> own_pipes;
+    std::unique_ptr<stream> new_stream =
+        make_stream(config.at("source"), seeder, concurrent ? own_pipes : pipes, osize);
 
-    auto search = pipes.find(pipe_id);
-    if (search == pipes.end()) {
-        // pipe_id is not yet in hashtable, create new entry
-        _source = std::make_shared<std::unique_ptr<stream>>(std::move(new_stream));
-        pipes[pipe_id] = _source;
-    } else {
-        // pipe_id is in hashtable, update the entry for pipe_out
-        *pipes[pipe_id] = std::move(new_stream);
-        _source = pipes[pipe_id];
+    _pipe = _impl::find_pipe(pipes, pipe_id);
+    auto &pipe = static_cast<_impl::pipe &>(**_pipe);
+    pipe.set_source(
+        std::move(new_stream), std::size_t(config.value("capacity", 16)), concurrent);
+    _consumer = pipe.add_consumer();
+}
+
+pipe_in_stream::~pipe_in_stream() {
+    static_cast<_impl::pipe &>(**_pipe).remove_consumer(_consumer);
+}
+
+vec_cview pipe_in_stream::next() {
+    return static_cast<_impl::pipe &>(**_pipe).next(_consumer);
+}
+
+pipe_out_stream::pipe_out_stream(
+    const json &config,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes)
+    : stream(0)
+    , _pipe(_impl::find_pipe(pipes, config.at("id")))
+    , _consumer(static_cast<_impl::pipe &>(**_pipe).add_consumer()) {}
+
+pipe_out_stream::~pipe_out_stream() {
+    static_cast<_impl::pipe &>(**_pipe).remove_consumer(_consumer);
+}
+
+vec_cview pipe_out_stream::next() {
+    return static_cast<_impl::pipe &>(**_pipe).next(_consumer);
+}
+
+async_stream::async_stream(const json &config,
+                           std::unique_ptr<stream> source,
+                           const std::size_t osize)
+    : stream(osize)
+    , _pipe("async " + config.at("type").get<std::string>())
+    , _batch(config.value("batch", std::size_t(16)))
+    , _batches(nullptr)
+    , _read(0)
+    , _left(0) {
+    if (_batch == 0)
+        throw std::runtime_error("async stream needs a batch of at least one vector");
+
+    auto batches = std::make_unique<_impl::batch_stream>(std::move(source), _batch);
+    _batches = batches.get();
+    _pipe.set_source(std::move(batches), config.value("queue", std::size_t(4)), true);
+    _consumer = _pipe.add_consumer();
+}
+
+async_stream::~async_stream() {
+    _pipe.remove_consumer(_consumer);
+}
+
+vec_cview async_stream::next() {
+    // the batch stays in its slot until the next one is read, the vectors are views into it;
+    // after the last vector before an error no batch follows, the read rethrows the error
+    if (_left == 0 || _read == _batches->end()) {
+        _vector = _pipe.next(_consumer).begin();
+        _left = _batch;
+    }
+    auto vector = make_view(_vector, osize());
+    _vector += std::ptrdiff_t(osize());
+    --_left;
+    ++_read;
+    return vector;
+}
+
+// child streams of a node, the values with a type and the lists of them
+template <typename Function> static void for_each_child(const json &config, Function function) {
+    for (auto it = config.begin(); it != config.end(); ++it) {
+        if (it->is_object() && it->count("type"))
+            function(*it);
+        else if (it->is_array())
+            for (const auto &item : *it)
+                if (item.is_object() && item.count("type"))
+                    function(item);
+    }
+}
+
+// streams which use neither the seeder, pipes nor files (a file may change, or be a pipe itself),
+// every copy of them gives the same output
+static bool is_deterministic(const json &config) {
+    static const std::unordered_set<std::string> types = {"dummy_stream",
+                                                          "true_stream",
+                                                          "false_stream",
+                                                          "counter",
+                                                          "single_value_stream",
+                                                          "repeating_stream",
+                                                          "tuple_stream",
+                                                          "xor_stream",
+                                                          "combine",
+                                                          "column",
+                                                          "column_fixed_position",
+                                                          "hash",
+                                                          "sha3",
+                                                          "iterated_hash",
+                                                          "counter_hash",
+                                                          "block",
+                                                          "stream_cipher",
+                                                          "estream"};
+    if (types.count(config.at("type")) == 0)
+        return false;
+
+    bool deterministic = true;
+    for_each_child(config, [&deterministic](const json &child) {
+        deterministic = deterministic && is_deterministic(child);
+    });
+    return deterministic;
+}
+
+// sharing a leaf would only add a copy, a subgraph is worth it
+static bool is_shared(const json &config) {
+    if (config.count("share"))
+        return config.at("share");
+
+    bool composite = false;
+    for_each_child(config, [&composite](const json &) { composite = true; });
+    return composite && is_deterministic(config);
+}
+
+namespace _impl {
+
+shared_source::shared_source(const json &config,
+                             std::unique_ptr<stream> source,
+                             const std::size_t osize,
+                             std::string initial_state)
+    : stream(osize)
+    , _config(config)
+    , _deterministic(is_deterministic(config))
+    , _initial_state(std::move(initial_state))
+    , _source(std::move(source))
+    , _first(0) {}
+
+std::size_t shared_source::add_consumer() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cursors.push_back(0);
+    return _cursors.size() - 1;
+}
+
+void shared_source::remove_consumer(const std::size_t consumer) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cursors[consumer] = std::numeric_limits<std::uint64_t>::max();
+}
+
+bool shared_source::next(const std::size_t consumer, std::vector<value_type> &out) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const std::uint64_t index = _cursors[consumer];
+    if (index < _first)
+        return false;
+
+    while (_first + _vectors.size() <= index) {
+        std::uint64_t slowest = std::numeric_limits<std::uint64_t>::max();
+        for (const std::uint64_t cursor : _cursors) {
+            // a deterministic source does not wait for the consumers behind the window
+            if (_deterministic && cursor + window < index)
+                continue;
+            slowest = std::min(slowest, cursor);
+        }
+
+        std::vector<value_type> recycled;
+        while (!_vectors.empty() && _first < slowest) {
+            recycled = std::move(_vectors.front());
+            _vectors.pop_front();
+            ++_first;
+        }
+        // a copy of a seeded source would not give the same vectors, the slowest one is kept
+        if (!_deterministic && _vectors.size() >= window &&
+            (_vectors.size() + 1) * osize() > max_kept_size)
+            throw std::runtime_error("occurrences of the shared subgraph " + _config.dump() +
+                                     " are read more than 64 MiB apart, "
+                                     "set \"share\": false on it");
+
+        vec_cview view = _source->next();
+        recycled.assign(view.begin(), view.end());
+        _vectors.push_back(std::move(recycled));
+    }
+
+    ++_cursors[consumer];
+    const std::vector<value_type> &vector = _vectors[std::size_t(index - _first)];
+    std::copy(vector.begin(), vector.end(), out.begin());
+    return true;
+}
+
+void shared_source::save_state(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _source->save_state(out);
+    stream_state::write(out, _first);
+    stream_state::write(out, std::uint64_t(_vectors.size()));
+    for (const auto &vector : _vectors)
+        stream_state::write(out, vector);
+    stream_state::write(out, _cursors);
+}
+
+void shared_source::load_state(std::istream &in) {
+    // every consumer loads the same state, loading it again changes nothing
+    std::lock_guard<std::mutex> lock(_mutex);
+    _source->load_state(in);
+    stream_state::read(in, _first);
+    std::uint64_t vectors;
+    stream_state::read(in, vectors);
+    _vectors.resize(std::size_t(vectors));
+    for (auto &vector : _vectors)
+        stream_state::read(in, vector);
+
+    std::vector<std::uint64_t> cursors;
+    stream_state::read(in, cursors);
+    if (cursors.size() != _cursors.size())
+        throw std::runtime_error("state of a shared subgraph has other consumers");
+    _cursors = std::move(cursors);
+}
+
+} // namespace _impl
+
+shared_stream::shared_stream(std::shared_ptr<std::unique_ptr<stream>> source,
+                             const std::size_t osize)
+    : stream(osize)
+    , _shared(std::move(source))
+    , _consumer(static_cast<_impl::shared_source &>(**_shared).add_consumer())
+    , _read(0) {}
+
+shared_stream::~shared_stream() {
+    // the source does not keep vectors for it anymore
+    static_cast<_impl::shared_source &>(**_shared).remove_consumer(_consumer);
+}
+
+vec_cview shared_stream::next() {
+    if (_own)
+        return _own->next();
+
+    auto &shared = static_cast<_impl::shared_source &>(**_shared);
+    if (shared.next(_consumer, _data)) {
+        ++_read;
+        return make_cview(_data);
     }
+
+    // fell behind the window, a copy of the deterministic subgraph is read from here on
+    shared.remove_consumer(_consumer);
+    default_seed_source unused(std::uint64_t(0));
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> pipes;
+    _own = make_stream(shared.config(), unused, pipes, osize());
+    for (; _read > 0; --_read)
+        _own->next();
+    return _own->next();
+}
+
+void shared_stream::save_state(std::ostream &out) const {
+    stream_state::write(out, bool(_own));
+    stream_state::write(out, _read);
+    if (_own)
+        _own->save_state(out);
+    else
+        (*_shared)->save_state(out);
+}
+
+void shared_stream::load_state(std::istream &in) {
+    bool own;
+    stream_state::read(in, own);
+    stream_state::read(in, _read);
+    if (!own) {
+        (*_shared)->load_state(in);
+        return;
+    }
+
+    auto &shared = static_cast<_impl::shared_source &>(**_shared);
+    shared.remove_consumer(_consumer);
+    default_seed_source unused(std::uint64_t(0));
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> pipes;
+    _own = make_stream(shared.config(), unused, pipes, osize());
+    _own->load_state(in);
+}
+
+// prefix of the keys of shared subgraphs in the pipes, no pipe id starts with it
+static const std::string shared_key = "#shared ";
+
+void add_shared_subgraphs(
+    const std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &from,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &to) {
+    for (const auto &entry : from)
+        if (entry.first.compare(0, shared_key.size(), shared_key) == 0)
+            to.insert(entry);
 }
 
 tuple_stream::tuple_stream(
@@ -222,105 +1366,478 @@ tuple_stream::tuple_stream(
     }
 }
 
-std::unique_ptr<stream>
-make_stream(const json &config,
-            default_seed_source &seeder,
-            std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
-            const std::size_t osize) {
-    const std::string type = config.at("type");
+vec_cview bernoulli_distribution_stream::next() {
+    if (_fill == rng_fill::per_byte) {
+        std::generate_n(_data.data(), osize(), [this]() {
+            uint8_t out = 0;
+            for (unsigned i = 0; i < 8; ++i) {
+                out |= (_distribution(_rng) << i);
+            }
+            return out;
+        });
+        return make_cview(_data);
+    }
 
-    if (osize == 0 and type != "dummy_stream") { // we allow dummy stream with 0 size
-        logger::warning() << "Stream " + type + " have osize 0." << std::endl;
+    // bit j of the word is bit j % 8 of byte j / 8, as the bits go one by one above
+    for (std::size_t i = 0; i < osize(); i += 8) {
+        const std::uint64_t bits = bit_sliced_word();
+        for (std::size_t j = 0; j < 8 && i + j < osize(); ++j)
+            _data[i + j] = value_type(bits >> (8 * j));
     }
+    return make_cview(_data);
+}
+
+std::uint64_t bernoulli_distribution_stream::bit_sliced_word() {
+    if (_distribution.p() >= 1)
+        return std::numeric_limits<std::uint64_t>::max();
+
+    std::uint64_t bits = 0;
+    std::uint64_t undecided = std::numeric_limits<std::uint64_t>::max();
+    // about log2(64) + 2 words are needed before no lane is left undecided
+    for (int k = 63; k >= 0 && undecided != 0; --k) {
+        const std::uint64_t high = _rng();
+        const std::uint64_t random = high << 32 | _rng();
+        if (_threshold >> k & 1) {
+            bits |= undecided & ~random; // a zero below a one of p
+            undecided &= random;
+        } else {
+            undecided &= ~random;
+        }
+    }
+    // the lanes left have all 64 bits equal to p, so they are not below it
+    return bits;
+}
+
+_impl::alias_table binomial_distribution_stream::make_table() const {
+    const int n = _distribution.t();
+    const double p = _distribution.p();
+    std::vector<double> weights(256, 0.0);
+
+    if (p <= 0 || p >= 1) {
+        weights[p <= 0 ? 0 : std::size_t(n)] = 1;
+        return _impl::alias_table(weights);
+    }
+    for (int k = 0; k <= n; ++k)
+        weights[std::size_t(k)] = std::exp(std::lgamma(n + 1) - std::lgamma(k + 1) -
+                                           std::lgamma(n - k + 1) + k * std::log(p) +
+                                           (n - k) * std::log1p(-p));
+    return _impl::alias_table(weights);
+}
+
+_impl::alias_table normal_distribution_stream::make_table() const {
+    const double sigma_count = 4.0;
+    const double mean = _distribution.mean();
+    const double std_dev = _distribution.stddev();
+    const double limit = sigma_count * std_dev;
+    const auto cdf = [=](double x) {
+        return 0.5 * std::erfc((mean - x) / (std_dev * std::sqrt(2.0)));
+    };
+    std::vector<double> weights(256, 0.0);
+
+    // k comes from res in [k / 255 - 0.5, (k + 1) / 255 - 0.5) * 2 * limit, within the limits
+    for (std::size_t k = 0; k < 256; ++k) {
+        const double low = std::max(-limit, (double(k) / 255 - 0.5) * 2 * limit);
+        const double high = std::min(limit, (double(k + 1) / 255 - 0.5) * 2 * limit);
+        if (low < high)
+            weights[k] = cdf(high) - cdf(low);
+    }
+    return _impl::alias_table(weights);
+}
+
+// values above 255 wrap around, as the conversion to uint8_t did
+_impl::alias_table poisson_distribution_stream::make_table() const {
+    const double mean = _distribution.mean();
+    std::vector<double> weights(256, 0.0);
 
-    // trivial source only streams
-    if (type == "dummy_stream")
-        return std::make_unique<dummy_stream>(osize);
-    else if (type == "file_stream")
-        return std::make_unique<file_stream>(config, osize);
-    else if (type == "true_stream")
-        return std::make_unique<true_stream>(osize);
-    else if (type == "false_stream")
-        return std::make_unique<false_stream>(osize);
-    else if (type == "mt19937_stream")
-        return std::make_unique<mt19937_stream>(seeder, osize);
-    else if (type == "pcg32_stream" or type == "random_stream")
-        return std::make_unique<pcg32_stream>(seeder, osize);
-
-    else if (type == "counter")
-        return std::make_unique<counter>(osize);
-    else if (type == "random_start_counter")
-        return std::make_unique<random_start_counter>(seeder, osize);
-    else if (type == "sac")
-        return std::make_unique<sac_stream>(seeder, osize);
-    else if (type == "sac_fixed_position") {
-        const std::size_t pos = std::size_t(config.at("position"));
-        return std::make_unique<sac_fixed_pos_stream>(seeder, osize, pos);
-    } else if (type == "sac_2d_all_positions")
-        return std::make_unique<sac_2d_all_pos>(seeder, osize);
-    else if (type == "hw_counter")
-        return std::make_unique<hw_counter>(config, seeder, osize);
-
-    // sources with statistical distribution
-    else if (type == "bernoulli_distribution")
-        return std::make_unique<bernoulli_distribution_stream>(config, seeder, osize);
-    else if (type == "binomial_distribution")
-        return std::make_unique<binomial_distribution_stream>(config, seeder, osize);
-    else if (type == "normal_distribution")
-        return std::make_unique<normal_distribution_stream>(config, seeder, osize);
-    else if (type == "poisson_distribution")
-        return std::make_unique<poisson_distribution_stream>(config, seeder, osize);
-    else if (type == "exponential_distribution")
-        return std::make_unique<exponential_distribution_stream>(config, seeder, osize);
-
-    // modifiers -- streams that has other stream as an input (but are used as source before cipher)
-    else if (type == "single_value_stream")
-        return std::make_unique<single_value_stream>(config.at("source"), seeder, pipes, osize);
-    else if (type == "repeating_stream")
-        return std::make_unique<repeating_stream>(config, seeder, pipes, osize);
-    else if (type == "tuple_stream")
-        return std::make_unique<tuple_stream>(config, seeder, pipes, osize);
-
-    // pipes
-    else if (type == "pipe_in_stream")
-        return std::make_unique<pipe_in_stream>(config, seeder, pipes, osize);
-    else if (type == "pipe_out_stream")
-        return std::make_unique<pipe_out_stream>(config, pipes);
-
-    // postprocessing modifiers -- streams that has cipher stream as an input
-    else if (type == "xor_stream")
-        return std::make_unique<xor_stream>(config, seeder, pipes, osize);
-    else if (type == "column")
-        return std::make_unique<column_stream>(config, seeder, pipes, osize);
-    else if (type == "column_fixed_position") {
-        const std::size_t pos = std::size_t(config.at("position"));
-        return std::make_unique<column_fixed_position_stream>(config, seeder, pipes, osize, pos);
-    }
-
-    // mock streams for testing
+    // the tail beyond 40 standard deviations does not show in 2^-32 precision
+    const auto last = std::size_t(mean + 40 * std::sqrt(mean) + 40);
+    for (std::size_t k = 0; k <= last; ++k) {
+        const double x = double(k);
+        weights[k % 256] += std::exp(x * std::log(mean) - mean - std::lgamma(x + 1));
+    }
+    return _impl::alias_table(weights);
+}
+
+// values above 255 wrap around, as the conversion to uint8_t did, which scales all weights
+// of the geometric tail by the same factor
+_impl::alias_table exponential_distribution_stream::make_table() const {
+    const double lambda = _distribution.lambda();
+    std::vector<double> weights(256, 0.0);
+
+    for (std::size_t k = 0; k < 256; ++k)
+        weights[k] = std::exp(-lambda * double(k)) * -std::expm1(-lambda);
+    return _impl::alias_table(weights);
+}
+
+registry<stream_constructor> &stream_types() {
+    // function-local, so it exists before any of the registrations below adds to it
+    static registry<stream_constructor> types;
+    return types;
+}
+
+using pipe_map = std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>>;
+using stream_registration = registry<stream_constructor>::registration;
+
+// constructors of the common shapes
+template <typename Stream>
+static std::unique_ptr<stream>
+with_size(const json &, default_seed_source &, pipe_map &, const std::size_t osize) {
+    return std::make_unique<Stream>(osize);
+}
+
+template <typename Stream>
+static std::unique_ptr<stream>
+with_config(const json &config, default_seed_source &, pipe_map &, const std::size_t osize) {
+    return std::make_unique<Stream>(config, osize);
+}
+
+template <typename Stream>
+static std::unique_ptr<stream>
+with_seeder(const json &config, default_seed_source &seeder, pipe_map &, const std::size_t osize) {
+    return std::make_unique<Stream>(config, seeder, osize);
+}
+
+template <typename Stream>
+static std::unique_ptr<stream> with_seeded_rng(const json &config,
+                                               default_seed_source &seeder,
+                                               pipe_map &,
+                                               const std::size_t osize) {
+    return std::make_unique<Stream>(seeder, osize, _to_rng_fill(config));
+}
+
+template <typename Stream>
+static std::unique_ptr<stream> with_sources(const json &config,
+                                            default_seed_source &seeder,
+                                            pipe_map &pipes,
+                                            const std::size_t osize) {
+    return std::make_unique<Stream>(config, seeder, pipes, osize);
+}
+
+// trivial source only streams
+static const stream_registration trivial_streams[] = {
+    {stream_types(), {"dummy_stream"}, with_size<dummy_stream>},
+    {stream_types(), {"file_stream"}, with_config<file_stream>},
+    {stream_types(), {"true_stream"}, with_size<true_stream>},
+    {stream_types(), {"false_stream"}, with_size<false_stream>},
+    {stream_types(), {"mt19937_stream"}, with_seeded_rng<mt19937_stream>},
+    {stream_types(), {"pcg32_stream", "random_stream"}, with_seeded_rng<pcg32_stream>},
+    {stream_types(),
+     {"pcg32_lanes_stream"},
+     [](const json &, default_seed_source &seeder, pipe_map &, const std::size_t osize) {
+         return std::make_unique<pcg32_lanes_stream>(seeder, osize);
+     }},
+
+    {stream_types(), {"counter"}, with_config<counter>},
+    {stream_types(),
+     {"random_start_counter"},
+     [](const json &, default_seed_source &seeder, pipe_map &, const std::size_t osize) {
+         return std::make_unique<random_start_counter>(seeder, osize);
+     }},
+    {stream_types(), {"sac"}, with_seeded_rng<sac_stream>},
+    {stream_types(),
+     {"sac_fixed_position"},
+     [](const json &config, default_seed_source &seeder, pipe_map &, const std::size_t osize) {
+         const std::size_t pos = std::size_t(config.at("position"));
+         return std::make_unique<sac_fixed_pos_stream>(seeder, osize, pos, _to_rng_fill(config));
+     }},
+    {stream_types(), {"sac_2d_all_positions"}, with_seeded_rng<sac_2d_all_pos>},
+    {stream_types(), {"hw_counter"}, with_seeder<hw_counter>},
+};
+
+// sources with statistical distribution
+static const stream_registration distribution_streams[] = {
+    {stream_types(), {"bernoulli_distribution"}, with_seeder<bernoulli_distribution_stream>},
+    {stream_types(), {"binomial_distribution"}, with_seeder<binomial_distribution_stream>},
+    {stream_types(), {"normal_distribution"}, with_seeder<normal_distribution_stream>},
+    {stream_types(), {"poisson_distribution"}, with_seeder<poisson_distribution_stream>},
+    {stream_types(), {"exponential_distribution"}, with_seeder<exponential_distribution_stream>},
+};
+
+// modifiers -- streams that has other stream as an input (but are used as source before cipher)
+static const stream_registration modifier_streams[] = {
+    {stream_types(),
+     {"single_value_stream"},
+     [](const json &config, default_seed_source &seeder, pipe_map &pipes, std::size_t osize) {
+         return std::make_unique<single_value_stream>(config.at("source"), seeder, pipes, osize);
+     }},
+    {stream_types(), {"repeating_stream"}, with_sources<repeating_stream>},
+    {stream_types(), {"tuple_stream"}, with_sources<tuple_stream>},
+};
+
+// pipes
+static const stream_registration pipe_streams[] = {
+    {stream_types(), {"pipe_in_stream"}, with_sources<pipe_in_stream>},
+    {stream_types(),
+     {"pipe_out_stream"},
+     [](const json &config, default_seed_source &, pipe_map &pipes, const std::size_t) {
+         return std::make_unique<pipe_out_stream>(config, pipes);
+     }},
+};
+
+// postprocessing modifiers -- streams that has cipher stream as an input
+static const stream_registration postprocessing_streams[] = {
+    {stream_types(), {"xor_stream"}, with_sources<xor_stream>},
+    {stream_types(), {"combine"}, with_sources<combine_stream>},
+    {stream_types(), {"column"}, with_sources<column_stream>},
+    {stream_types(),
+     {"column_fixed_position"},
+     [](const json &config, default_seed_source &seeder, pipe_map &pipes, std::size_t osize) {
+         // "position": single bit, "positions": list of bits or "all" of them, in turns
+         std::vector<std::size_t> positions;
+         if (config.count("positions") == 0)
+             positions.push_back(std::size_t(config.at("position")));
+         else if (config.at("positions").is_string() && config.at("positions") == "all")
+             for (std::size_t pos = 0; pos < std::size_t(config.at("size")) * 8; ++pos)
+                 positions.push_back(pos);
+         else
+             for (const auto &pos : config.at("positions"))
+                 positions.push_back(std::size_t(pos));
+         return std::make_unique<column_fixed_position_stream>(
+             config, seeder, pipes, osize, std::move(positions));
+     }},
+};
+
+// mock streams for testing
 #if (BUILD_testsuite && TEST_STREAM)
-    else if (type == "test_stream")
-        return std::make_unique<testsuite::test_stream>(config);
+static const stream_registration test_streams[] = {
+    {stream_types(),
+     {"test_stream"},
+     [](const json &config, default_seed_source &, pipe_map &, const std::size_t) {
+         return std::make_unique<testsuite::test_stream>(config);
+     }},
+};
 #endif
 
-        // cryptoprimitives streams
+// cryptoprimitives streams, registered here rather than next to them: the families are static
+// libraries and the linker leaves out their objects nothing refers to
 #ifdef BUILD_stream_ciphers
-    else if (type == "stream_cipher" or type == "estream")
-        return std::make_unique<stream_ciphers::stream_stream>(config, seeder, pipes, osize);
+static const stream_registration stream_cipher_streams[] = {
+    {stream_types(), {"stream_cipher", "estream"}, with_sources<stream_ciphers::stream_stream>},
+};
 #endif
 #ifdef BUILD_hash
-    else if (type == "hash" || type == "sha3")
-        return std::make_unique<hash::hash_stream>(config, seeder, pipes, osize);
+static const stream_registration hash_streams[] = {
+    {stream_types(), {"hash", "sha3"}, with_sources<hash::hash_stream>},
+    {stream_types(), {"iterated_hash"}, with_sources<hash::iterated_hash_stream>},
+    {stream_types(), {"counter_hash"}, with_sources<hash::counter_hash_stream>},
+};
 #endif
 #ifdef BUILD_block
-    else if (type == "block")
-        return std::make_unique<block::block_stream>(config, seeder, pipes, osize);
+static const stream_registration block_streams[] = {
+    {stream_types(), {"block"}, with_sources<block::block_stream>},
+};
 #endif
 #ifdef BUILD_prngs
-    else if (type == "prng")
-        return std::make_unique<prng::prng_stream>(config, seeder, osize, pipes);
+static const stream_registration prng_streams[] = {
+    {stream_types(),
+     {"prng"},
+     [](const json &config, default_seed_source &seeder, pipe_map &pipes, std::size_t osize) {
+         return std::make_unique<prng::prng_stream>(config, seeder, osize, pipes);
+     }},
+};
 #endif
-    throw std::runtime_error("requested stream named \"" + type + "\" does not exist");
+
+// a fused node replaces the ones it is made of, so they must not have keys it would drop
+static bool has_only_keys(const json &config, std::initializer_list<const char *> keys) {
+    for (auto it = config.begin(); it != config.end(); ++it)
+        if (std::find(keys.begin(), keys.end(), it.key()) == keys.end())
+            return false;
+    return true;
+}
+
+// xor_stream is the fold of two segments of its source with xor
+static bool as_fold(const json &config, std::string &operation, std::size_t &segments) {
+    const std::string type = config.at("type");
+    if (type == "xor_stream" && has_only_keys(config, {"type", "source", "fuse"})) {
+        operation = "xor";
+        segments = 2;
+        return true;
+    }
+    if (type == "combine" &&
+        has_only_keys(config, {"type", "operation", "segments", "source", "fuse"})) {
+        operation = config.value("operation", "xor");
+        segments = std::size_t(config.value("segments", 2));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * The operations are associative and commutative, a fold of folds is one fold of all segments.
+ * The words of an addition wider than a byte have to start at every segment of osize bytes,
+ * otherwise the inner fold adds words across the outer segments and the carries differ.
+ */
+static bool fuse_folds(const json &config, json &fused, const std::size_t osize) {
+    std::string outer_operation, inner_operation;
+    std::size_t outer_segments, inner_segments;
+    if (!as_fold(config, outer_operation, outer_segments) ||
+        !as_fold(config.at("source"), inner_operation, inner_segments) ||
+        outer_operation != inner_operation)
+        return false;
+
+    const std::size_t word = word_size(_to_combine_operation(outer_operation));
+    if (word > 1 && osize % word != 0)
+        return false;
+
+    fused = {{"type", "combine"},
+             {"operation", outer_operation},
+             {"segments", outer_segments * inner_segments},
+             {"source", config.at("source").at("source")}};
+    return true;
+}
+
+#ifdef BUILD_hash
+static bool as_hashes(const json &config, std::size_t &iterations) {
+    const std::string type = config.at("type");
+    if (!has_only_keys(config,
+                       {"type",
+                        "algorithm",
+                        "round",
+                        "hash_size",
+                        "input_size",
+                        "implementation",
+                        "iterations",
+                        "source",
+                        "fuse"}))
+        return false;
+    if (type == "hash" || type == "sha3") {
+        iterations = 1;
+        return true;
+    }
+    if (type == "iterated_hash") {
+        iterations = std::size_t(config.at("iterations"));
+        return true;
+    }
+    return false;
+}
+
+// a hash of hashes of the same function is an iterated hash, hashed in batches without copies
+static bool fuse_hashes(const json &config, json &fused) {
+    std::size_t outer_iterations, inner_iterations;
+    if (!as_hashes(config, outer_iterations) ||
+        !as_hashes(config.at("source"), inner_iterations))
+        return false;
+
+    const json &inner = config.at("source");
+    for (const char *key : {"algorithm", "round", "hash_size"})
+        if (config.at(key) != inner.at(key))
+            return false;
+    if (config.value("implementation", "optimized") != inner.value("implementation", "optimized"))
+        return false;
+    // the outer function hashes the digests of the inner one
+    if (config.count("input_size") && config.at("input_size") != config.at("hash_size"))
+        return false;
+
+    fused = inner;
+    fused["type"] = "iterated_hash";
+    fused["iterations"] = outer_iterations + inner_iterations;
+    fused.erase("fuse");
+    return true;
+}
+
+// a hash of a counter hashes its values where the counter writes them, in batches
+static bool fuse_counter_hash(const json &config, json &fused) {
+    std::size_t iterations;
+    if (!as_hashes(config, iterations))
+        return false;
+    const json &source = config.at("source");
+    if (source.at("type") != "counter" ||
+        !has_only_keys(source, {"type", "endianness", "step", "fuse"}))
+        return false;
+
+    fused = config;
+    fused["type"] = "counter_hash";
+    fused["iterations"] = iterations;
+    fused.erase("fuse");
+    return true;
+}
+#endif
+
+// fuses the node with its source, fused is set only when they have a fused kernel
+static bool fuse_step(const json &config, json &fused, const std::size_t osize) {
+    if (!config.value("fuse", true) || config.count("source") == 0 ||
+        !config.at("source").value("fuse", true))
+        return false;
+#ifdef BUILD_hash
+    if (fuse_hashes(config, fused) || fuse_counter_hash(config, fused))
+        return true;
+#endif
+    return fuse_folds(config, fused, osize);
+}
+
+json compile_stream(json config, const std::size_t osize) {
+    json fused;
+    while (fuse_step(config, fused, osize))
+        config = std::move(fused);
+    return config;
+}
+
+std::unique_ptr<stream>
+make_stream(const json &config,
+            default_seed_source &seeder,
+            std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+            const std::size_t osize) {
+    // a chain with a fused kernel is built as its single node, the node is fused further if it can
+    json fused;
+    if (fuse_step(config, fused, osize))
+        return make_stream(fused, seeder, pipes, osize);
+
+    // a named subgraph is built as on its own, it reads the shared one when that starts the same
+    auto share_it = config.find("share");
+    if (share_it != config.end() && share_it->is_string()) {
+        json single = config;
+        single["share"] = false;
+        auto source = make_stream(single, seeder, pipes, osize);
+        std::ostringstream state;
+        try {
+            source->save_state(state);
+        } catch (std::runtime_error &) {
+            return source;
+        }
+
+        auto &shared = pipes[shared_key + share_it->get<std::string>() + " " +
+                             std::to_string(osize) + " " + single.dump()];
+        if (!shared)
+            shared = std::make_shared<std::unique_ptr<stream>>(
+                std::make_unique<_impl::shared_source>(single, std::move(source), osize,
+                                                       state.str()));
+        else if (static_cast<_impl::shared_source &>(**shared).initial_state() != state.str())
+            return source;
+        return std::make_unique<shared_stream>(shared, osize);
+    }
+
+    // identical subgraphs are built once, under a key no pipe id starts with
+    if (is_shared(config)) {
+        auto &shared = pipes[shared_key + std::to_string(osize) + " " + config.dump()];
+        if (!shared) {
+            json single = config;
+            single["share"] = false;
+            auto source = make_stream(single, seeder, pipes, osize);
+            shared = std::make_shared<std::unique_ptr<stream>>(
+                std::make_unique<_impl::shared_source>(single, std::move(source), osize));
+        }
+        return std::make_unique<shared_stream>(shared, osize);
+    }
+
+    // the node runs on a worker of its own, with its own pipes
+    if (config.value("async", false)) {
+        json node = config;
+        node["async"] = false;
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> own_pipes;
+        return std::make_unique<async_stream>(
+            config, make_stream(node, seeder, own_pipes, osize), osize);
+    }
+
+    const std::string type = config.at("type");
+
+    if (osize == 0 and type != "dummy_stream") { // we allow dummy stream with 0 size
+        logger::warning() << "Stream " + type + " have osize 0." << std::endl;
+    }
+
+    const stream_constructor *constructor = stream_types().find(type);
+    if (constructor == nullptr)
+        throw std::runtime_error("requested stream named \"" + type + "\" does not exist");
+    return (*constructor)(config, seeder, pipes, osize);
 }
 
 void stream_to_dataset(dataset &set, std::unique_ptr<stream> &source) {
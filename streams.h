@@ -1,11 +1,22 @@
 #pragma once
 
+#include "pcg32_lanes.h"
+#include "registry.h"
+#include "spmc_ring.h"
 #include "stream.h"
 #include <eacirc-core/json.h>
 #include <eacirc-core/optional.h>
 #include <eacirc-core/random.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <random>
+#include <thread>
 
 #ifdef BUILD_testsuite
 #include <testsuite/test_utils/test_streams.h>
@@ -27,8 +38,67 @@
 #include <streams/hash/hash_stream.h>
 #endif
 
+/**
+ * Version of filling byte vectors from a random generator, "rng_version" in the config:
+ * 1 (default) draws a whole output of the generator for every byte (or every bit of a biased
+ * stream) and samples the std distributions, as the datasets generated so far did, 2 stores
+ * all bytes of every output (least significant first), draws biased bits 64 at a time and
+ * samples the distributions of bytes from alias tables.
+ */
+enum class rng_fill { per_byte = 1, whole_outputs = 2 };
+
+rng_fill _to_rng_fill(const json &config);
+
 namespace _impl {
 
+template <typename Generator>
+void fill_random(Generator &rng, value_type *data, const std::size_t size, const rng_fill fill) {
+    if (fill == rng_fill::per_byte) {
+        std::generate_n(
+            data, size, [&rng]() { return std::uniform_int_distribution<std::uint8_t>()(rng); });
+        return;
+    }
+
+    // the generators in use give either 32 or 64 random bits
+    const std::size_t bytes = Generator::max() > 0xffffffffu ? 8 : 4;
+    std::size_t i = 0;
+    for (; i + bytes <= size; i += bytes) {
+        const std::uint64_t value = rng();
+        for (std::size_t j = 0; j < bytes; ++j)
+            data[i + j] = value_type(value >> (8 * j));
+    }
+    if (i < size) {
+        const std::uint64_t value = rng();
+        for (std::size_t j = 0; i + j < size; ++j)
+            data[i + j] = value_type(value >> (8 * j));
+    }
+}
+
+/**
+ * Walker's alias method over the 256 byte values, in Vose's construction. One 32-bit output
+ * of the generator gives one byte: its top 8 bits pick a column, the low 24 bits choose
+ * between the value of the column and its alias. The probability of each value is thus kept
+ * to 2^-32.
+ */
+struct alias_table {
+    alias_table() = default;
+    // weights of the byte values 0 to 255, they do not have to sum to one
+    explicit alias_table(const std::vector<double> &weights);
+
+    template <typename Generator> value_type operator()(Generator &rng) const {
+        const auto random = std::uint32_t(rng());
+        const std::uint32_t column = random >> 24;
+        return (random & 0xffffff) < _threshold[column] ? value_type(column) : _alias[column];
+    }
+
+    // probability of value as sampled, in tests
+    double probability(const value_type value) const;
+
+private:
+    std::array<std::uint32_t, 256> _threshold = {};
+    std::array<value_type, 256> _alias = {};
+};
+
 template <std::uint8_t value> struct const_stream : stream {
     const_stream(const std::size_t osize)
         : stream(osize) {
@@ -36,23 +106,31 @@ template <std::uint8_t value> struct const_stream : stream {
     }
 
     vec_cview next() override { return make_cview(_data); }
+
+    void save_state(std::ostream &) const override {}
+    void load_state(std::istream &) override {}
 };
 
 template <typename Generator> struct rng_stream : stream {
     template <typename Seeder>
-    rng_stream(Seeder &&seeder, const std::size_t osize)
+    rng_stream(Seeder &&seeder,
+               const std::size_t osize,
+               const rng_fill fill = rng_fill::per_byte)
         : stream(osize)
-        , _rng(std::forward<Seeder>(seeder)) {}
+        , _rng(std::forward<Seeder>(seeder))
+        , _fill(fill) {}
 
     vec_cview next() override {
-        std::generate_n(_data.data(), osize(), [this]() {
-            return std::uniform_int_distribution<std::uint8_t>()(_rng);
-        });
+        fill_random(_rng, _data.data(), osize(), _fill);
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override { stream_state::write_text(out, _rng); }
+    void load_state(std::istream &in) override { stream_state::read_text(in, _rng); }
+
 private:
     Generator _rng;
+    const rng_fill _fill;
 };
 
 } // namespace _impl
@@ -65,19 +143,45 @@ struct dummy_stream : stream {
         : stream(osize) {}
 
     vec_cview next() override { return make_cview(_data); }
+
+    void save_state(std::ostream &out) const override { stream_state::write(out, _data); }
+    void load_state(std::istream &in) override { stream_state::read(in, _data); }
 };
 
 /**
  * @brief Stream of data read from a file
+ *
+ * Vectors start at "offset" bytes (0 by default) and then every "stride" bytes (osize by
+ * default), at most "limit" of them are read (unlimited by default). With "loop", the stream
+ * goes back to the offset after the last vector instead of throwing. With "mmap" (POSIX only),
+ * the file is mapped to memory with sequential read-ahead advised and vectors are copied
+ * from the mapping, no system call is made per vector.
  */
 struct file_stream : stream {
     file_stream(const json &config, const std::size_t osize);
+    ~file_stream() override;
 
     vec_cview next() override;
 
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
+    bool read_mapped();
+    bool read_file();
+
     const std::string _path;
     std::ifstream _istream;
+    const std::uint64_t _offset;
+    const std::uint64_t _stride;
+    const std::uint64_t _limit;
+    const bool _loop;
+    const bool _mapped;
+    // vectors read since the offset
+    std::uint64_t _index;
+
+    const value_type *_mapping;
+    std::size_t _mapping_size;
 };
 
 /**
@@ -92,6 +196,9 @@ struct repeating_stream : stream {
 
     vec_cview next() override;
 
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
     std::unique_ptr<stream> _source;
     const unsigned _period;
@@ -109,15 +216,44 @@ struct single_value_stream : stream {
         const std::size_t osize);
 
     vec_cview next() override;
+
+    void save_state(std::ostream &) const override {}
+    void load_state(std::istream &) override {}
 };
 
 /**
  * @brief Stream of counter
+ *
+ * The counter is incremented in 64-bit limbs, so a carry is propagated a word at a time. Options
+ * "endianness" ("little" by default, or "big") sets the byte order of the output and "step"
+ * (1 by default) the increment between two consecutive values.
  */
 struct counter : stream {
     counter(const std::size_t osize);
+    counter(const json &config, const std::size_t osize);
 
     vec_cview next() override;
+
+    /**
+     * Write count next values back to back to out (count * osize() bytes), the stream
+     * continues after the last of them.
+     */
+    void next_batch(value_type *out, const std::size_t count);
+
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
+private:
+    // adds the step to the value stored in the output byte order, a limb at a time
+    void increment(value_type *value) const;
+    std::uint64_t load_limb(const value_type *value, const std::size_t i) const;
+    void store_limb(value_type *value, const std::size_t i, const std::uint64_t limb) const;
+
+    const bool _big_endian;
+    const std::uint64_t _step;
+    const std::size_t _limbs;
+    // the most significant limb may be shorter than 8 bytes when osize is not a multiple of 8
+    const std::uint64_t _top_mask;
 };
 
 /**
@@ -139,10 +275,53 @@ struct xor_stream : stream {
 
     vec_cview next() override;
 
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
     std::unique_ptr<stream> _source;
 };
 
+/**
+ * Operation of combine_stream, the additions go modulo 2^k in little-endian words of k bits
+ */
+enum class combine_operation { bitwise_xor, bitwise_and, bitwise_or, add8, add16, add32, add64 };
+
+combine_operation _to_combine_operation(const std::string &name);
+
+/**
+ * out = out operation in, byte by byte (or word by word)
+ */
+void combine_bytes(value_type *out,
+                   const value_type *in,
+                   const std::size_t size,
+                   const combine_operation operation);
+
+/**
+ * @brief Stream combining several inputs with one operation
+ *
+ * The inputs are the vectors of the streams in "sources", or "segments" consecutive parts of
+ * one vector of "source". The "operation" is one of xor (default), and, or, add8, add16, add32
+ * and add64, a vector not divisible into the words ends with a shorter word. The inputs are
+ * folded into the output in place, 32 bytes at a time in SIMD registers.
+ */
+struct combine_stream : stream {
+    combine_stream(const json &config,
+                   default_seed_source &seeder,
+                   std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+                   const std::size_t osize);
+
+    vec_cview next() override;
+
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
+private:
+    const combine_operation _operation;
+    const std::size_t _segments;
+    std::vector<std::unique_ptr<stream>> _sources;
+};
+
 /**
  * @brief Stream for testing strict avalanche criterion
  *
@@ -153,16 +332,17 @@ private:
  */
 struct sac_stream : stream {
     template <typename Seeder>
-    sac_stream(Seeder &&seeder, const std::size_t osize)
+    sac_stream(Seeder &&seeder,
+               const std::size_t osize,
+               const rng_fill fill = rng_fill::per_byte)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
+        , _fill(fill)
         , _first(true) {}
 
     vec_cview next() override {
         if (_first) {
-            std::generate_n(_data.data(), osize(), [this]() {
-                return std::uniform_int_distribution<std::uint8_t>()(_rng);
-            });
+            _impl::fill_random(_rng, _data.data(), osize(), _fill);
         } else {
             std::uniform_int_distribution<std::size_t> dist{0, (osize() * 8) - 1};
             std::size_t pos = dist(_rng);
@@ -173,8 +353,21 @@ struct sac_stream : stream {
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write(out, _data);
+        stream_state::write(out, _first);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read(in, _data);
+        stream_state::read(in, _first);
+    }
+
 private:
     pcg32 _rng;
+    const rng_fill _fill;
     bool _first;
 };
 
@@ -182,9 +375,11 @@ struct sac_fixed_pos_stream : stream {
     template <typename Seeder>
     sac_fixed_pos_stream(Seeder &&seeder,
                          const std::size_t osize,
-                         const std::size_t flip_bit_position)
+                         const std::size_t flip_bit_position,
+                         const rng_fill fill = rng_fill::per_byte)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
+        , _fill(fill)
         , _flip_bit_position(flip_bit_position)
         , _first(true) {
         if (_flip_bit_position >= osize * 8)
@@ -194,9 +389,7 @@ struct sac_fixed_pos_stream : stream {
 
     vec_cview next() override {
         if (_first) {
-            std::generate_n(_data.data(), osize(), [this]() {
-                return std::uniform_int_distribution<std::uint8_t>()(_rng);
-            });
+            _impl::fill_random(_rng, _data.data(), osize(), _fill);
         } else {
             _data[_flip_bit_position / 8] ^= (1 << (_flip_bit_position % 8));
         }
@@ -204,25 +397,39 @@ struct sac_fixed_pos_stream : stream {
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write(out, _data);
+        stream_state::write(out, _first);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read(in, _data);
+        stream_state::read(in, _first);
+    }
+
 private:
     pcg32 _rng;
+    const rng_fill _fill;
     const std::size_t _flip_bit_position;
     bool _first;
 };
 
 struct sac_2d_all_pos : stream {
     template <typename Seeder>
-    sac_2d_all_pos(Seeder &&seeder, const std::size_t osize)
+    sac_2d_all_pos(Seeder &&seeder,
+                   const std::size_t osize,
+                   const rng_fill fill = rng_fill::per_byte)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
+        , _fill(fill)
         , _origin_data(osize)
         , _flip_bit_position(0) {}
 
     vec_cview next() override {
         if (_flip_bit_position == 0) {
-            std::generate_n(_data.data(), osize(), [this]() {
-                return std::uniform_int_distribution<std::uint8_t>()(_rng);
-            });
+            _impl::fill_random(_rng, _data.data(), osize(), _fill);
             std::copy_n(_data.begin(), osize(), _origin_data.begin());
         } else {
             std::copy_n(_origin_data.begin(), osize(), _data.begin());
@@ -235,18 +442,43 @@ struct sac_2d_all_pos : stream {
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write(out, _data);
+        stream_state::write(out, _origin_data);
+        stream_state::write(out, _flip_bit_position);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read(in, _data);
+        stream_state::read(in, _origin_data);
+        stream_state::read(in, _flip_bit_position);
+    }
+
 private:
     pcg32 _rng;
+    const rng_fill _fill;
     // storing copy is not optimal, can be done faster with more conditions
     std::vector<value_type> _origin_data;
     std::size_t _flip_bit_position;
 };
 
+/**
+ * @brief Stream of vectors of a fixed Hamming weight, the set bits go through all their
+ * combinations in lexicographic order of the positions
+ *
+ * Any index of the sequence can be reached at once (seek, or "start_index" in the config) by
+ * unranking it in the combinatorial number system. Streams started at different indices thus
+ * split one sequence between threads with the same output. Outputs of up to 64 bits keep the
+ * combination packed in a single word and step it with Gosper's hack.
+ */
 struct hw_counter : stream {
     template <typename Seeder>
     hw_counter(const json &config, Seeder &&seeder, const std::size_t osize)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
+        , _fill(_to_rng_fill(config))
         , _origin_data(osize)
         , _increase_hw(config.value("increase_hw", true))
         , _randomize_overflow(config.value("randomize_overflow", false))
@@ -267,12 +499,14 @@ struct hw_counter : stream {
             std::fill_n(_origin_data.begin(), osize, 0);
         }
 
-        combination_init();
+        save_start();
+        seek(config.value("start_index", std::uint64_t(0)));
     }
 
     hw_counter(const std::size_t osize)
             : stream(osize)
             , _rng()
+            , _fill(rng_fill::per_byte)
             , _origin_data(osize)
             , _increase_hw(true)
             , _randomize_overflow(false)
@@ -287,52 +521,57 @@ struct hw_counter : stream {
 
         std::fill_n(_origin_data.begin(), osize, 0);
 
-        combination_init();
+        save_start();
+        seek(0);
     }
 
     vec_cview next() override;
 
-private:
-    void randomize() {
-        std::generate_n(_origin_data.data(), osize(), [this]() {
-            return std::uniform_int_distribution<std::uint8_t>()(_rng);
-        });
-    }
+    /**
+     * Move to the vector of the given index of the sequence (counted from the start of the
+     * stream), the next call of next returns it.
+     */
+    void seek(std::uint64_t index);
 
-    void combination_init() {
-        _cur_positions.clear();
-        for (std::size_t i = 0; i < _cur_hw; ++i) {
-            _cur_positions.push_back(i);
-        }
-    }
-
-    bool combination_next() {
-        const auto size = static_cast<int64_t>(_cur_positions.size());
-        auto idx = size - 1;
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
 
-        if (_cur_positions[idx] == osize() * 8 - 1) {
-            do {
-                idx -= 1;
-            } while (idx >= 0 && _cur_positions[idx] + 1 == _cur_positions[idx + 1]);
+private:
+    void randomize() { _impl::fill_random(_rng, _origin_data.data(), osize(), _fill); }
 
-            if (idx < 0) {
-                return false;
-            }
+    void save_start() {
+        _start_rng = _rng;
+        _start_origin_data = _origin_data;
+        _start_hw = _cur_hw;
+    }
 
-            for (auto j = idx + 1; j < size; ++j) {
-                _cur_positions[j] = _cur_positions[idx] + j - idx + 1;
-            }
-        }
-        _cur_positions[idx]++;
-        return true;
+    // the next Hamming weight or origin once all combinations of the current one were used
+    void overflow();
+    void combination_init(std::uint64_t rank);
+    bool combination_next();
+    void write_word();
+    void flip(const std::size_t position) {
+        _data[position / 8] ^= value_type(1 << (position % 8));
     }
 
     pcg32 _rng;
+    const rng_fill _fill;
     std::vector<value_type> _origin_data;
     const bool _increase_hw;
     const bool _randomize_overflow;
     std::size_t _cur_hw;
     std::vector<std::size_t> _cur_positions;
+
+    // outputs of up to 64 bits: position p is bit (bits - 1 - p) of the complement of _word,
+    // so the lexicographic order of positions is the ascending order of the words
+    std::uint64_t _word;
+    std::uint64_t _last_word;
+
+    pcg32 _start_rng;
+    std::vector<value_type> _start_origin_data;
+    std::size_t _start_hw;
+    // the vector in _data was returned already, move to the next combination first
+    bool _advance;
 };
 
 struct column_stream : stream {
@@ -343,10 +582,13 @@ struct column_stream : stream {
 
     vec_cview next() override;
 
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
     std::size_t _internal_bit_size;
-    std::vector<std::vector<value_type>>
-        _buf; // change to array (maxe osize() constexpression), or init it to given size
+    std::vector<value_type> _rows; // osize() * 8 source vectors, back to back
+    std::vector<value_type> _buf;  // _internal_bit_size output vectors, back to back
     std::size_t _position;
     std::unique_ptr<stream> _source;
 };
@@ -357,12 +599,25 @@ struct column_fixed_position_stream : stream {
         default_seed_source &seeder,
         std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
         const std::size_t osize,
-        const std::size_t position);
+        std::vector<std::size_t> positions);
 
+    /**
+     * Columns of the requested positions, in turns. Every column of a turn comes from the same
+     * batch of osize() * 8 source vectors, generated once per turn.
+     */
     vec_cview next() override;
 
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
-    const std::size_t _position;
+    const std::size_t _size;
+    const std::vector<std::size_t> _positions;
+    // source bytes holding a requested bit, with their (bit, output slot) pairs
+    std::vector<std::pair<std::size_t, std::vector<std::pair<std::size_t, std::size_t>>>> _bytes;
+    std::vector<value_type> _rows; // osize() * 8 source vectors, back to back
+    std::vector<value_type> _buf;  // output vectors of all positions, back to back
+    std::size_t _i;
     std::unique_ptr<stream> _source;
 };
 
@@ -374,22 +629,35 @@ struct bernoulli_distribution_stream : stream {
     bernoulli_distribution_stream(const json &config, Seeder &&seeder, const std::size_t osize)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
-        , _distribution(std::bernoulli_distribution(double(config.value("p", 0.5)))) {}
+        , _distribution(std::bernoulli_distribution(double(config.value("p", 0.5))))
+        , _fill(_to_rng_fill(config))
+        , _threshold(_distribution.p() < 1 ? std::uint64_t(std::ldexp(_distribution.p(), 64))
+                                           : std::numeric_limits<std::uint64_t>::max()) {}
 
-    vec_cview next() override {
-        std::generate_n(_data.data(), osize(), [this]() {
-            uint8_t out = 0;
-            for (unsigned i = 0; i < 8; ++i) {
-                out |= (_distribution(_rng) << i);
-            }
-            return out;
-        });
-        return make_cview(_data);
+    vec_cview next() override;
+
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write_text(out, _distribution);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read_text(in, _distribution);
     }
 
 private:
+    /**
+     * 64 bits at once, each set with probability p in 64-bit fixed point: the i-th random word
+     * gives bit i of 64 uniform numbers, the numbers are compared to the binary expansion
+     * of p from the top and each lane is decided at the first bit where they differ.
+     */
+    std::uint64_t bit_sliced_word();
+
     pcg32 _rng;
     std::bernoulli_distribution _distribution;
+    const rng_fill _fill;
+    const std::uint64_t _threshold;
 };
 
 /**
@@ -401,16 +669,35 @@ struct binomial_distribution_stream : stream {
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
         , _distribution(uint8_t(config.value("max_value", std::numeric_limits<uint8_t>::max())),
-                        double(config.value("p", 0.5))) {}
+                        double(config.value("p", 0.5)))
+        , _fill(_to_rng_fill(config))
+        , _table(_fill == rng_fill::per_byte ? _impl::alias_table() : make_table()) {}
 
     vec_cview next() override {
-        std::generate_n(_data.data(), osize(), [this]() { return _distribution(_rng); });
+        if (_fill == rng_fill::per_byte)
+            std::generate_n(_data.data(), osize(), [this]() { return _distribution(_rng); });
+        else
+            std::generate_n(_data.data(), osize(), [this]() { return _table(_rng); });
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write_text(out, _distribution);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read_text(in, _distribution);
+    }
+
 private:
+    _impl::alias_table make_table() const;
+
     pcg32 _rng;
     std::binomial_distribution<uint8_t> _distribution;
+    const rng_fill _fill;
+    const _impl::alias_table _table;
 };
 
 /**
@@ -423,9 +710,16 @@ struct normal_distribution_stream : stream {
     normal_distribution_stream(const json &config, Seeder &&seeder, const std::size_t osize)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
-        , _distribution(double(config.value("mean", 0)), double(config.value("std_dev", 1.0))) {}
+        , _distribution(double(config.value("mean", 0)), double(config.value("std_dev", 1.0)))
+        , _fill(_to_rng_fill(config))
+        , _table(_fill == rng_fill::per_byte ? _impl::alias_table() : make_table()) {}
 
     vec_cview next() override {
+        if (_fill != rng_fill::per_byte) {
+            std::generate_n(_data.data(), osize(), [this]() { return _table(_rng); });
+            return make_cview(_data);
+        }
+
         std::generate_n(_data.data(), osize(), [this]() {
             double res;
             double sigma_count = 4.0;
@@ -440,9 +734,24 @@ struct normal_distribution_stream : stream {
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write_text(out, _distribution);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read_text(in, _distribution);
+    }
+
 private:
+    // the values above, with the 4 sigma cut and the scaling done on the exact distribution
+    _impl::alias_table make_table() const;
+
     pcg32 _rng;
     std::normal_distribution<double> _distribution;
+    const rng_fill _fill;
+    const _impl::alias_table _table;
 };
 
 /**
@@ -453,16 +762,35 @@ struct poisson_distribution_stream : stream {
     poisson_distribution_stream(const json &config, Seeder &&seeder, const std::size_t osize)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
-        , _distribution(double(config.value("mean", std::numeric_limits<uint8_t>::max() / 2))) {}
+        , _distribution(double(config.value("mean", std::numeric_limits<uint8_t>::max() / 2)))
+        , _fill(_to_rng_fill(config))
+        , _table(_fill == rng_fill::per_byte ? _impl::alias_table() : make_table()) {}
 
     vec_cview next() override {
-        std::generate_n(_data.data(), osize(), [this]() { return _distribution(_rng); });
+        if (_fill == rng_fill::per_byte)
+            std::generate_n(_data.data(), osize(), [this]() { return _distribution(_rng); });
+        else
+            std::generate_n(_data.data(), osize(), [this]() { return _table(_rng); });
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write_text(out, _distribution);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read_text(in, _distribution);
+    }
+
 private:
+    _impl::alias_table make_table() const;
+
     pcg32 _rng;
     std::poisson_distribution<uint8_t> _distribution;
+    const rng_fill _fill;
+    const _impl::alias_table _table;
 };
 
 /**
@@ -473,60 +801,206 @@ struct exponential_distribution_stream : stream {
     exponential_distribution_stream(const json &config, Seeder &&seeder, const std::size_t osize)
         : stream(osize)
         , _rng(std::forward<Seeder>(seeder))
-        , _distribution(double(config.value("lambda", 1))) {}
+        , _distribution(double(config.value("lambda", 1)))
+        , _fill(_to_rng_fill(config))
+        , _table(_fill == rng_fill::per_byte ? _impl::alias_table() : make_table()) {}
 
     vec_cview next() override {
-        std::generate_n(_data.data(), osize(), [this]() { return uint8_t(_distribution(_rng)); });
+        if (_fill == rng_fill::per_byte)
+            std::generate_n(
+                _data.data(), osize(), [this]() { return uint8_t(_distribution(_rng)); });
+        else
+            std::generate_n(_data.data(), osize(), [this]() { return _table(_rng); });
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        stream_state::write_text(out, _rng);
+        stream_state::write_text(out, _distribution);
+    }
+
+    void load_state(std::istream &in) override {
+        stream_state::read_text(in, _rng);
+        stream_state::read_text(in, _distribution);
+    }
+
 private:
+    _impl::alias_table make_table() const;
+
     pcg32 _rng;
     std::exponential_distribution<double> _distribution;
+    const rng_fill _fill;
+    const _impl::alias_table _table;
 };
 
+namespace _impl {
+
 /**
- * @brief Pipe's sink - stores pointer on the intersnal stream to
- * the pipes hashtable
+ * Pipe of the pipe streams with the same id, kept in the pipes hashtable. Its source writes
+ * the vectors to a ring, every pipe stream reads all of them in order. By default the source
+ * is run by the pipe stream which needs a vector nobody has read yet, a pipe stream must not
+ * fall capacity - 1 vectors behind then. A pipe stream within the source itself reads the
+ * vector before the one being computed. A concurrent pipe runs its source on a thread of its
+ * own, as far ahead of the pipe streams as the ring allows. The thread and the pipe streams
+ * waiting on a full or an empty ring spin for a while and then sleep until the other side
+ * moves.
+ */
+struct pipe : stream {
+    explicit pipe(const std::string &id);
+    ~pipe() override;
+
+    vec_cview next() override { throw std::logic_error("pipe is read by its pipe streams"); }
+
+    void set_source(std::unique_ptr<stream> source, const std::size_t capacity, bool concurrent);
+
+    std::size_t add_consumer();
+    void remove_consumer(const std::size_t consumer);
+
+    vec_cview next(const std::size_t consumer);
+
+private:
+    void produce();
+    void run();
+
+    // waits until the condition holds, the other side wakes the waiting ones after every change
+    template <typename Condition> void wait(Condition condition);
+    void wake();
+
+    const std::string _id;
+    std::unique_ptr<stream> _source;
+    std::unique_ptr<spmc_ring> _ring;
+    // consumers added before the source, they join the ring with it
+    std::size_t _pending_consumers;
+    // the source is running on this thread, and the vector read before the first one
+    bool _producing;
+    std::vector<value_type> _initial;
+
+    bool _concurrent;
+    // the first read starts the thread, pipe streams on several threads may read first at once
+    std::once_flag _started;
+    std::thread _producer;
+    std::atomic<bool> _stop;
+    std::atomic<bool> _failed;
+    std::exception_ptr _error;
+
+    std::mutex _wait_mutex;
+    std::condition_variable _changed;
+    std::atomic<unsigned> _waiting;
+};
+
+std::shared_ptr<std::unique_ptr<stream>>
+find_pipe(std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+          const std::string &id);
+
+/**
+ * Batch next vectors of the source back to back in one vector. When the source fails within a
+ * batch, the vectors before are returned as a batch of their own and the next call throws.
+ */
+struct batch_stream : stream {
+    batch_stream(std::unique_ptr<stream> source, const std::size_t batch)
+        : stream(source->osize() * batch)
+        , _source(std::move(source))
+        , _produced(0)
+        , _end(std::numeric_limits<std::uint64_t>::max()) {}
+
+    vec_cview next() override {
+        if (_error)
+            std::rethrow_exception(_error);
+
+        const std::uint64_t first = _produced;
+        try {
+            for (auto it = _data.begin(); it != _data.end(); ++_produced) {
+                vec_cview view = _source->next();
+                it = std::copy(view.begin(), view.end(), it);
+            }
+        } catch (...) {
+            if (_produced == first)
+                throw;
+            _error = std::current_exception();
+            _end.store(_produced, std::memory_order_release);
+        }
+        return make_cview(_data);
+    }
+
+    /** Vectors of the source before it failed, the last batch holds only the rest of them */
+    std::uint64_t end() const { return _end.load(std::memory_order_acquire); }
+
+private:
+    std::unique_ptr<stream> _source;
+    std::uint64_t _produced;
+    // read by the consumer of the batches on another thread
+    std::atomic<std::uint64_t> _end;
+    std::exception_ptr _error;
+};
+
+} // namespace _impl
+
+/**
+ * @brief Stage of the graph running on a thread of its own
+ *
+ * make_stream builds a node with "async": true as usual and runs it on a worker thread, the
+ * stage reads it through a bounded ring: "queue" (4 by default) slots of "batch" (16 by
+ * default) vectors each. The worker stops when the ring is full and the reads wait for it when
+ * the ring is empty, so the stages of a chain overlap without running away from each other.
+ * The output is the same as without "async", a node failing within a batch gives the vectors
+ * before the error first. The node is built with its own pipes, the pipe streams inside it do
+ * not connect to the rest of the graph.
+ */
+struct async_stream : stream {
+    async_stream(const json &config,
+                 std::unique_ptr<stream> source,
+                 const std::size_t osize);
+    ~async_stream() override;
+
+    vec_cview next() override;
+
+private:
+    _impl::pipe _pipe;
+    std::size_t _consumer;
+    const std::size_t _batch;
+    // source of the pipe, and the vectors read from it
+    const _impl::batch_stream *_batches;
+    std::uint64_t _read;
+    // next vector of the batch read last
+    std::vector<value_type>::const_iterator _vector;
+    std::size_t _left;
+};
+
+/**
+ * @brief Pipe's sink - runs the source of the pipe and reads it as well
+ *
+ * Option "capacity" (16 by default) is the number of vectors the pipe keeps, "concurrent"
+ * (false by default) runs the source on a thread of its own. The source of a concurrent pipe
+ * is built on its own, it does not share pipes with the rest of the graph.
  */
 struct pipe_in_stream : stream {
     pipe_in_stream(const json &config,
                    default_seed_source &seeder,
                    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
                    const std::size_t osize);
+    ~pipe_in_stream() override;
 
-    vec_cview next() override { return (*_source)->next(); }
+    vec_cview next() override;
 
 private:
-    std::shared_ptr<std::unique_ptr<stream>> _source;
+    std::shared_ptr<std::unique_ptr<stream>> _pipe;
+    std::size_t _consumer;
 };
 
 /**
- * @brief Pipe's source
+ * @brief Pipe's source - reads the vectors of the pipe with the same id, in order
  */
 struct pipe_out_stream : stream {
     pipe_out_stream(
         const json &config,
-        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes)
-        : stream(0) {
-        std::string pipe_id = config.at("id");
-
-        auto search = pipes.find(pipe_id);
-        if (search == pipes.end()) {
-            // pipe_id is not yet in hashtable, create new empty entry
-            _source =
-                std::make_shared<std::unique_ptr<stream>>(std::unique_ptr<stream>(nullptr));
-            pipes[pipe_id] = _source;
-        } else {
-            // pipe_id is in hashtable, use ptr from pipe_in
-            _source = pipes[pipe_id];
-        }
-    }
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes);
+    ~pipe_out_stream() override;
 
-    vec_cview next() override { return (*_source)->get_data(); }
+    vec_cview next() override;
 
 private:
-    std::shared_ptr<std::unique_ptr<stream>> _source;
+    std::shared_ptr<std::unique_ptr<stream>> _pipe;
+    std::size_t _consumer;
 };
 
 /**
@@ -549,10 +1023,117 @@ struct tuple_stream : stream {
         return make_cview(_data);
     }
 
+    void save_state(std::ostream &out) const override {
+        for (const auto &source : _sources)
+            source->save_state(out);
+    }
+
+    void load_state(std::istream &in) override {
+        for (auto &source : _sources)
+            source->load_state(in);
+    }
+
 private:
     std::vector<std::unique_ptr<stream>> _sources;
 };
 
+namespace _impl {
+
+/**
+ * Source of the identical subgraphs of a config built once, see shared_stream. It keeps the
+ * vectors some consumer has not read yet. A deterministic source keeps at most window of them,
+ * the consumers further behind read their own copy of the subgraph from then on. A seeded one
+ * has no such copy, it keeps up to max_kept_size bytes of vectors and then throws. The consumers
+ * may read from different threads, each vector is copied out under a lock.
+ */
+struct shared_source : stream {
+    static constexpr std::size_t window = 16;
+    static constexpr std::size_t max_kept_size = std::size_t(1) << 26;
+
+    shared_source(const json &config,
+                  std::unique_ptr<stream> source,
+                  const std::size_t osize,
+                  std::string initial_state = std::string());
+
+    vec_cview next() override { return _source->next(); }
+
+    /** Registers a consumer, it starts at the first vector */
+    std::size_t add_consumer();
+
+    /** Copies the next vector of the consumer to out, false when it fell behind the window */
+    bool next(const std::size_t consumer, std::vector<value_type> &out);
+
+    /** Consumer reads its own copy from now on, it does not hold back the window anymore */
+    void remove_consumer(const std::size_t consumer);
+
+    /** The source, the vectors kept and the cursors of all consumers */
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
+    const json &config() const { return _config; }
+    bool deterministic() const { return _deterministic; }
+    // saved state of a named source before its first vector
+    const std::string &initial_state() const { return _initial_state; }
+
+private:
+    const json _config;
+    const bool _deterministic;
+    const std::string _initial_state;
+    std::unique_ptr<stream> _source;
+
+    mutable std::mutex _mutex;
+    // vectors from the index _first on, the slowest consumer has not read them yet
+    std::deque<std::vector<value_type>> _vectors;
+    std::uint64_t _first;
+    std::vector<std::uint64_t> _cursors;
+};
+
+} // namespace _impl
+
+/**
+ * @brief Consumer of a subgraph shared with the identical ones
+ *
+ * make_stream builds identical deterministic subgraphs with the same output size once, every
+ * occurrence reads the same vectors. Deterministic subgraphs use neither the seeder, pipes nor
+ * files, the ones with a child stream are shared by default. "share": true shares a subgraph that
+ * draws from the seeder as well, every occurrence is then the very same stream instead of one
+ * seeded on its own, as long as no occurrence reads more than 64 MiB ahead of another one (a
+ * key read once, for example, cannot be shared with a plaintext). "share": false builds the
+ * subgraph on its own.
+ *
+ * "share": "<name>" shares a seeded subgraph by its name instead of its config text, the graphs
+ * built with the same pipes (the variants of a sweep) read one stream of it. Every occurrence is
+ * still built with the seeder as if it was on its own, and reads the shared stream only when it
+ * starts in the very same state, otherwise (or when its state cannot be saved) it reads its own
+ * copy. Two occurrences under other names in one graph are never the same stream.
+ */
+struct shared_stream : stream {
+    shared_stream(std::shared_ptr<std::unique_ptr<stream>> source, const std::size_t osize);
+    ~shared_stream() override;
+
+    vec_cview next() override;
+
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
+private:
+    std::shared_ptr<std::unique_ptr<stream>> _shared;
+    std::size_t _consumer;
+
+    // copy of the subgraph once the consumer fell behind, and the vectors it has read
+    std::unique_ptr<stream> _own;
+    std::uint64_t _read;
+};
+
+/**
+ * Adds the subgraphs shared in the pipes of a graph to the pipes of another one, the identical
+ * subgraphs of a graph built with them read the same vectors as in the first one. Pipe streams
+ * are not added, their ids stay within the graph.
+ */
+void add_shared_subgraphs(
+    const std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &from,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &to);
+
 /**
  * \brief Stream of true bits
  */
@@ -573,6 +1154,50 @@ using mt19937_stream = _impl::rng_stream<std::mt19937>;
  */
 using pcg32_stream = _impl::rng_stream<pcg32>;
 
+/**
+ * \brief Stream of data produced by 8 independent PCG generators advanced together in SIMD
+ * lanes, output words go lane after lane
+ */
+struct pcg32_lanes_stream : stream {
+    template <typename Seeder>
+    pcg32_lanes_stream(Seeder &&seeder, const std::size_t osize)
+        : stream(osize)
+        , _rng(std::forward<Seeder>(seeder)) {}
+
+    vec_cview next() override {
+        _rng.fill(_data.data(), osize());
+        return make_cview(_data);
+    }
+
+    void save_state(std::ostream &out) const override { stream_state::write(out, _rng); }
+    void load_state(std::istream &in) override { stream_state::read(in, _rng); }
+
+private:
+    pcg32_lanes _rng;
+};
+
+using stream_constructor = std::function<std::unique_ptr<stream>(
+    const json &config,
+    default_seed_source &seeder,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+    std::size_t osize)>;
+
+/**
+ * Stream types make_stream constructs, keyed by the "type" of the config
+ */
+registry<stream_constructor> &stream_types();
+
+/**
+ * Fuses the chains of the config with a specialized kernel into a single node, the rest is kept
+ * as it is. A fold (xor_stream or combine with segments) of a fold with the same operation
+ * becomes one combine over all the segments, an addition of words wider than a byte only when
+ * osize is a multiple of the word. A hash of a hash with the same function becomes an
+ * iterated_hash, and a hash of a counter a counter_hash, the counter writes its values straight
+ * into the messages. The output is the same either way. make_stream compiles every node it
+ * constructs, "fuse": false keeps a node as it is written.
+ */
+json compile_stream(json config, std::size_t osize);
+
 std::unique_ptr<stream>
 make_stream(const json &config,
             default_seed_source &seeder,
@@ -1,42 +1,80 @@
 #include "block_factory.h"
+#include <registry.h>
 
 namespace block {
 
 struct block_cipher;
 
-std::unique_ptr<block_cipher> make_block_cipher(const std::string &name,
-                                                const std::size_t round,
+template <typename Cipher>
+static std::unique_ptr<block_cipher>
+with_rounds(const std::size_t round, const std::size_t, const std::size_t, const bool) {
+    return std::make_unique<Cipher>(round);
+}
+
+// ciphers with separate encryption and decryption
+template <typename Cipher>
+static std::unique_ptr<block_cipher>
+with_direction(const std::size_t round, const std::size_t, const std::size_t, const bool encrypt) {
+    return std::make_unique<Cipher>(round, encrypt);
+}
+
+// ciphers with a choice of the block and key size
+template <typename Cipher>
+static std::unique_ptr<block_cipher> with_sizes(const std::size_t round,
                                                 const std::size_t block_size,
                                                 const std::size_t key_size,
-                                                const bool encrypt) {
+                                                const bool) {
+    return std::make_unique<Cipher>(round, block_size, key_size);
+}
+
+using block_cipher_constructor =
+    std::unique_ptr<block_cipher> (*)(std::size_t, std::size_t, std::size_t, bool);
+
+static const registry<block_cipher_constructor> &block_cipher_types() {
     // clang-format off
-    if (name == "TEA")  return std::make_unique<tea>(round);
-    if (name == "AES")  return std::make_unique<aes>(round);
-    if (name == "ARIA")  return std::make_unique<aria::aria>(round, encrypt);
-    if (name == "CAMELLIA")  return std::make_unique<camellia::camellia>(round, encrypt);
-    if (name == "CAST")  return std::make_unique<cast::cast>(round);
-    if (name == "IDEA")  return std::make_unique<idea::idea>(round, encrypt);
-    if (name == "GOST")  return std::make_unique<gost>(round);
-    if (name == "SIMON")  return std::make_unique<simon>(round, block_size, key_size);
-    if (name == "SPECK")  return std::make_unique<speck>(round, block_size, key_size);
-    if (name == "SINGLE-DES")  return std::make_unique<single_des>(round, encrypt);
-    if (name == "TRIPLE-DES")  return std::make_unique<triple_des>(round, encrypt);
-    if (name == "BLOWFISH") return std::make_unique<blowfish_factory>(round);
-    if (name == "MARS") return std::make_unique<mars::mars>(round, encrypt);
-    if (name == "RC6") return std::make_unique<rc6::rc6>(round, encrypt);
-    if (name == "SERPENT") return std::make_unique<serpent::serpent>(round, encrypt);
-    if (name == "TWOFISH") return std::make_unique<twofish::twofish>(round);
-    if (name == "SEED") return std::make_unique<seed::seed>(round);
-    if (name == "KASUMI") return std::make_unique<kasumi_factory>(round);
-    if (name == "KUZNYECHIK") return std::make_unique<kuznyechik_factory>(round);
-    if (name == "MISTY1") return std::make_unique<misty1_factory>(round);
-    if (name == "NOEKEON") return std::make_unique<noekeon_factory>(round);
-    if (name == "SHACAL2") return std::make_unique<shacal2_factory>(round);
-    if (name == "XTEA") return std::make_unique<xtea_factory>(round);
+    static const registry<block_cipher_constructor> ciphers = {
+        {"TEA",        with_rounds<tea>},
+        {"AES",        with_rounds<aes>},
+        {"ARIA",       with_direction<aria::aria>},
+        {"CAMELLIA",   with_direction<camellia::camellia>},
+        {"CAST",       with_rounds<cast::cast>},
+        {"IDEA",       with_direction<idea::idea>},
+        {"GOST",       with_rounds<gost>},
+        {"SIMON",      with_sizes<simon>},
+        {"SPECK",      with_sizes<speck>},
+        {"SINGLE-DES", with_direction<single_des>},
+        {"TRIPLE-DES", with_direction<triple_des>},
+        {"BLOWFISH",   with_rounds<blowfish_factory>},
+        {"MARS",       with_direction<mars::mars>},
+        {"RC6",        with_direction<rc6::rc6>},
+        {"SERPENT",    with_direction<serpent::serpent>},
+        {"TWOFISH",    with_rounds<twofish::twofish>},
+        {"SEED",       with_rounds<seed::seed>},
+        {"KASUMI",     with_rounds<kasumi_factory>},
+        {"KUZNYECHIK", with_rounds<kuznyechik_factory>},
+        {"MISTY1",     with_rounds<misty1_factory>},
+        {"NOEKEON",    with_rounds<noekeon_factory>},
+        {"SHACAL2",    with_rounds<shacal2_factory>},
+        {"XTEA",       with_rounds<xtea_factory>},
+    };
     // clang-format on
+    return ciphers;
+}
 
-    throw std::runtime_error("requested block cipher named \"" + name +
-                             "\" is either broken or does not exists");
+std::vector<std::string> block_cipher_names() {
+    return block_cipher_types().names();
+}
+
+std::unique_ptr<block_cipher> make_block_cipher(const std::string &name,
+                                                const std::size_t round,
+                                                const std::size_t block_size,
+                                                const std::size_t key_size,
+                                                const bool encrypt) {
+    const block_cipher_constructor *constructor = block_cipher_types().find(name);
+    if (constructor == nullptr)
+        throw std::runtime_error("requested block cipher named \"" + name +
+                                 "\" is either broken or does not exists");
+    return (*constructor)(round, block_size, key_size, encrypt);
 }
 
 } // namespace block
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "ciphers/aes/aes.h"
 #include "ciphers/aria/aria_block.h"
@@ -35,4 +36,7 @@ std::unique_ptr<block_cipher> make_block_cipher(const std::string &name,
                                                 const std::size_t block_size,
                                                 const std::size_t key_size,
                                                 const bool encrypt);
+
+/** Names of all the ciphers make_block_cipher knows */
+std::vector<std::string> block_cipher_names();
 }
@@ -61,8 +61,7 @@ block_stream::block_stream(
     _encryptor->ivsetup(iv_view.data(), iv_view.size());
     */
 
-    vec_cview key_view = _key->next();
-    _encryptor->keysetup(key_view.data(), std::uint32_t(key_view.size()));
+    keysetup(_key->next());
 }
 
 block_stream::block_stream(block_stream &&) = default;
@@ -70,10 +69,8 @@ block_stream::~block_stream() = default;
 
 vec_cview block_stream::next() {
     ++_i;
-    if (_reinit_freq != -1 && _i % std::size_t(_reinit_freq) == 0) {
-        vec_cview key_view = _key->next();
-        _encryptor->keysetup(key_view.data(), std::uint32_t(key_view.size()));
-    }
+    if (_reinit_freq != -1 && _i % std::size_t(_reinit_freq) == 0)
+        keysetup(_key->next());
 
     for (auto ctx_beg = _data.begin();
          ctx_beg != _data.end();) { // ctx_beg += _source->osize() from inside
@@ -87,4 +84,27 @@ vec_cview block_stream::next() {
     return make_view(_data.cbegin(), osize());
 }
 
+void block_stream::save_state(std::ostream &out) const {
+    stream_state::write(out, _i);
+    stream_state::write(out, _key_data);
+    _source->save_state(out);
+    _iv->save_state(out);
+    _key->save_state(out);
+}
+
+void block_stream::load_state(std::istream &in) {
+    stream_state::read(in, _i);
+    std::vector<value_type> key;
+    stream_state::read(in, key);
+    keysetup(make_cview(key));
+    _source->load_state(in);
+    _iv->load_state(in);
+    _key->load_state(in);
+}
+
+void block_stream::keysetup(vec_cview key) {
+    _key_data.assign(key.begin(), key.end());
+    _encryptor->keysetup(_key_data.data(), std::uint32_t(_key_data.size()));
+}
+
 } // namespace block
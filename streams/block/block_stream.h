@@ -22,7 +22,12 @@ public:
 
     vec_cview next() override;
 
+    /** The input streams and the key in use, the cipher is keyed with it again on load */
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
+    void keysetup(vec_cview key);
 
     const std::size_t _round;
     const std::size_t _block_size;
@@ -32,6 +37,7 @@ private:
     std::unique_ptr<stream> _source;
     std::unique_ptr<stream> _iv;
     std::unique_ptr<stream> _key;
+    std::vector<value_type> _key_data;
 
     const bool _run_encryption;
     std::unique_ptr<block_cipher> _encryptor;
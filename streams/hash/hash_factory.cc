@@ -1,5 +1,6 @@
 #include "hash_factory.h"
 #include "hash_interface.h"
+#include <registry.h>
 #include "others/hash_functions/hash_functions.h"
 #include "sha3/hash_functions/hash_functions.h"
 
@@ -11,88 +12,141 @@ void _check_rounds(const std::string &algorithm, const unsigned rounds) {
                                  "\" cannot be limited in rounds"};
 }
 
+hash_implementation _to_implementation(const std::string &name) {
+    if (name == "optimized")
+        return hash_implementation::optimized;
+    if (name == "reference")
+        return hash_implementation::reference;
+    throw std::runtime_error{"requested hash implementation named \"" + name +
+                             "\" does not exist, use \"optimized\" or \"reference\""};
+}
+
 std::unique_ptr<hash_interface> hash_factory::create(const std::string &name,
-                                                     const unsigned rounds) {
-    // clang-format off
-    if (name == "Abacus")         return std::make_unique<sha3::Abacus>(rounds);
-    if (name == "ARIRANG")        return std::make_unique<sha3::Arirang>(rounds);
-    if (name == "AURORA")         return std::make_unique<sha3::Aurora>(rounds);
-    if (name == "BLAKE")          return std::make_unique<sha3::Blake>(rounds);
-    if (name == "Blender")        return std::make_unique<sha3::Blender>(rounds);
-    if (name == "BMW")            return std::make_unique<sha3::BMW>(rounds);
-    if (name == "Boole")          return std::make_unique<sha3::Boole>(rounds);
-    if (name == "Cheetah")        return std::make_unique<sha3::Cheetah>(rounds);
-    if (name == "CHI")            return std::make_unique<sha3::Chi>(rounds);
-    if (name == "CRUNCH")         return std::make_unique<sha3::Crunch>(rounds);
-    if (name == "CubeHash")       return std::make_unique<sha3::Cubehash>(rounds);
-    if (name == "DCH")            return std::make_unique<sha3::DCH>(rounds);
-    if (name == "DynamicSHA")     return std::make_unique<sha3::DSHA>(rounds);
-    if (name == "DynamicSHA2")    return std::make_unique<sha3::DSHA2>(rounds);
-    if (name == "ECHO")           return std::make_unique<sha3::Echo>(rounds);
-    // if (name == "ECOH")           return std::make_unique<Ecoh>(rounds);
-    if (name == "EDON") {         _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::Edon>();
-    }
-    // if (name == "EnRUPT")         return std::make_unique<Enrupt>(rounds);
-    if (name == "ESSENCE")        return std::make_unique<sha3::Essence>(rounds);
-    if (name == "Fugue")          return std::make_unique<sha3::Fugue>(rounds);
-    if (name == "Grostl")         return std::make_unique<sha3::Grostl>(rounds);
-    if (name == "Hamsi")          return std::make_unique<sha3::Hamsi>(rounds);
-    if (name == "JH")             return std::make_unique<sha3::JH>(rounds);
-    if (name == "Keccak")         return std::make_unique<sha3::Keccak>(rounds);
-    if (name == "Khichidi") {     _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::Khichidi>();
-    }
-    if (name == "LANE")           return std::make_unique<sha3::Lane>(rounds);
-    if (name == "Lesamnta")       return std::make_unique<sha3::Lesamnta>(rounds);
-    if (name == "Luffa")          return std::make_unique<sha3::Luffa>(rounds);
-    // if (name == "LUX")            return std::make_unique<Lux>(rounds);
-    if (name == "MCSSHA3") {      _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::Mscsha>();
-    }
-    if (name == "MD6")            return std::make_unique<sha3::MD6>(rounds);
-    if (name == "MeshHash")       return std::make_unique<sha3::MeshHash>(rounds);
-    if (name == "NaSHA") {        _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::Nasha>();
-    }
-    // if (name == "SANDstorm")      return std::make_unique<SandStorm>(rounds);
-    if (name == "Sarmal")         return std::make_unique<sha3::Sarmal>(rounds);
-    if (name == "Shabal") {       _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::Shabal>();
+                                                     const unsigned rounds,
+                                                     const hash_implementation implementation) {
+    if (implementation == hash_implementation::optimized) {
+        auto hasher = create_optimized(name, rounds);
+        if (hasher)
+            return hasher;
     }
-    if (name == "SHAMATA") {      _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::Shamata>();
-    }
-    if (name == "SHAvite3")       return std::make_unique<sha3::SHAvite>(rounds);
-    if (name == "SIMD")           return std::make_unique<sha3::Simd>(rounds);
-    if (name == "Skein")          return std::make_unique<sha3::Skein>(rounds);
-    if (name == "SpectralHash") { _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::SpectralHash>();
-    }
-    if (name == "StreamHash") {   _check_rounds(name, rounds);
-                                  return std::make_unique<sha3::StreamHash>();
-    }
-    // if (name == "SWIFFTX")        return std::make_unique<Swifftx>(rounds);
-    if (name == "Tangle")         return std::make_unique<sha3::Tangle>(rounds);
-    // if (name == "TIB3")           return std::make_unique<Tib>(rounds);
-    if (name == "Twister")        return std::make_unique<sha3::Twister>(rounds);
-    //if (name == "Vortex")         return std::make_unique<Vortex>(rounds);
-    if (name == "WaMM")           return std::make_unique<sha3::WaMM>(rounds);
-    if (name == "Waterfall")      return std::make_unique<sha3::Waterfall>(rounds);
-    if (name == "Tangle2")        return std::make_unique<sha3::Tangle2>(rounds);
+    return create_reference(name, rounds);
+}
+
+template <typename Hash>
+static std::unique_ptr<hash_interface> with_rounds(const std::string &, const unsigned rounds) {
+    return std::make_unique<Hash>(rounds);
+}
+
+template <typename Hash>
+static std::unique_ptr<hash_interface> without_rounds(const std::string &name,
+                                                      const unsigned rounds) {
+    _check_rounds(name, rounds);
+    return std::make_unique<Hash>();
+}
+
+using hash_constructor = std::unique_ptr<hash_interface> (*)(const std::string &, unsigned);
+
+// functions with an optimized implementation next to the reference one, Skein is not among
+// them: its reference rounds are unrolled C already, and SSE2 cannot rotate the 64-bit words
+// of Threefish-512 each by its own count
+static const registry<hash_constructor> &optimized_functions() {
+    // clang-format off
+    static const registry<hash_constructor> functions = {
+        {"BLAKE",          with_rounds<sha3::Blake_opt>},
+        {"CubeHash",       with_rounds<sha3::Cubehash_opt>},
+        {"Grostl",         with_rounds<sha3::Grostl_opt>},
+        {"JH",             with_rounds<sha3::JH_opt>},
+    };
+    // clang-format on
+    return functions;
+}
+
+static const registry<hash_constructor> &reference_functions() {
+    // clang-format off
+    static const registry<hash_constructor> functions = {
+        {"Abacus",         with_rounds<sha3::Abacus>},
+        {"ARIRANG",        with_rounds<sha3::Arirang>},
+        {"AURORA",         with_rounds<sha3::Aurora>},
+        {"BLAKE",          with_rounds<sha3::Blake>},
+        {"Blender",        with_rounds<sha3::Blender>},
+        {"BMW",            with_rounds<sha3::BMW>},
+        {"Boole",          with_rounds<sha3::Boole>},
+        {"Cheetah",        with_rounds<sha3::Cheetah>},
+        {"CHI",            with_rounds<sha3::Chi>},
+        {"CRUNCH",         with_rounds<sha3::Crunch>},
+        {"CubeHash",       with_rounds<sha3::Cubehash>},
+        {"DCH",            with_rounds<sha3::DCH>},
+        {"DynamicSHA",     with_rounds<sha3::DSHA>},
+        {"DynamicSHA2",    with_rounds<sha3::DSHA2>},
+        {"ECHO",           with_rounds<sha3::Echo>},
+        // {"ECOH",           with_rounds<Ecoh>},
+        {"EDON",           without_rounds<sha3::Edon>},
+        // {"EnRUPT",         with_rounds<Enrupt>},
+        {"ESSENCE",        with_rounds<sha3::Essence>},
+        {"Fugue",          with_rounds<sha3::Fugue>},
+        {"Grostl",         with_rounds<sha3::Grostl>},
+        {"Hamsi",          with_rounds<sha3::Hamsi>},
+        {"JH",             with_rounds<sha3::JH>},
+        {"Keccak",         with_rounds<sha3::Keccak>},
+        {"Khichidi",       without_rounds<sha3::Khichidi>},
+        {"LANE",           with_rounds<sha3::Lane>},
+        {"Lesamnta",       with_rounds<sha3::Lesamnta>},
+        {"Luffa",          with_rounds<sha3::Luffa>},
+        // {"LUX",            with_rounds<Lux>},
+        {"MCSSHA3",        without_rounds<sha3::Mscsha>},
+        {"MD6",            with_rounds<sha3::MD6>},
+        {"MeshHash",       with_rounds<sha3::MeshHash>},
+        {"NaSHA",          without_rounds<sha3::Nasha>},
+        // {"SANDstorm",      with_rounds<SandStorm>},
+        {"Sarmal",         with_rounds<sha3::Sarmal>},
+        {"Shabal",         without_rounds<sha3::Shabal>},
+        {"SHAMATA",        without_rounds<sha3::Shamata>},
+        {"SHAvite3",       with_rounds<sha3::SHAvite>},
+        {"SIMD",           with_rounds<sha3::Simd>},
+        {"Skein",          with_rounds<sha3::Skein>},
+        {"SpectralHash",   without_rounds<sha3::SpectralHash>},
+        {"StreamHash",     without_rounds<sha3::StreamHash>},
+        // {"SWIFFTX",        with_rounds<Swifftx>},
+        {"Tangle",         with_rounds<sha3::Tangle>},
+        // {"TIB3",           with_rounds<Tib>},
+        {"Twister",        with_rounds<sha3::Twister>},
+        // {"Vortex",         with_rounds<Vortex>},
+        {"WaMM",           with_rounds<sha3::WaMM>},
+        {"Waterfall",      with_rounds<sha3::Waterfall>},
+        {"Tangle2",        with_rounds<sha3::Tangle2>},
 
-    if (name == "SHA1")           return std::make_unique<others::sha1_factory>(rounds);
-    if (name == "SHA2")           return std::make_unique<others::sha256_factory>(rounds);
-    if (name == "SHA3")           return std::make_unique<others::sha3_factory>(rounds);
-    if (name == "MD5")            return std::make_unique<others::md5_factory>(rounds);
-    if (name == "Gost")           return std::make_unique<others::Gost>(rounds);
-    if (name == "RIPEMD160")      return std::make_unique<others::Ripemd160>(rounds);
-    if (name == "Tiger")          return std::make_unique<others::Tiger>(rounds);
-    if (name == "Whirlpool")      return std::make_unique<others::Whirlpool>(rounds);
+        {"SHA1",           with_rounds<others::sha1_factory>},
+        {"SHA2",           with_rounds<others::sha256_factory>},
+        {"SHA3",           with_rounds<others::sha3_factory>},
+        {"MD5",            with_rounds<others::md5_factory>},
+        {"Gost",           with_rounds<others::Gost>},
+        {"RIPEMD160",      with_rounds<others::Ripemd160>},
+        {"Tiger",          with_rounds<others::Tiger>},
+        {"Whirlpool",      with_rounds<others::Whirlpool>},
+    };
     // clang-format on
+    return functions;
+}
+
+std::vector<std::string> hash_factory::algorithms() {
+    return reference_functions().names();
+}
+
+std::unique_ptr<hash_interface> hash_factory::create_optimized(const std::string &name,
+                                                               const unsigned rounds) {
+    const hash_constructor *constructor = optimized_functions().find(name);
+
+    // no optimized implementation, the reference one is used
+    return constructor ? (*constructor)(name, rounds) : nullptr;
+}
 
-    throw std::runtime_error("requested hash algorithm named \"" + name +
-                             "\" is either broken or does not exists");
+std::unique_ptr<hash_interface> hash_factory::create_reference(const std::string &name,
+                                                               const unsigned rounds) {
+    const hash_constructor *constructor = reference_functions().find(name);
+    if (constructor == nullptr)
+        throw std::runtime_error("requested hash algorithm named \"" + name +
+                                 "\" is either broken or does not exists");
+    return (*constructor)(name, rounds);
 }
 
 } // namespace hash
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace hash {
 
@@ -9,9 +10,29 @@ struct hash_interface;
 
 void _check_rounds(const std::string &algorithm, const unsigned rounds);
 
+/**
+ * Functions can have an optimized implementation registered next to the reference one.
+ * The optimized one is created by default, the reference one stays available to cross-check
+ * it. Both give the same digests for every number of rounds.
+ */
+enum class hash_implementation { optimized, reference };
+
+hash_implementation _to_implementation(const std::string &name);
+
 struct hash_factory {
-    static std::unique_ptr<hash_interface> create(const std::string &algorithm,
-                                                  const unsigned rounds);
+    static std::unique_ptr<hash_interface>
+    create(const std::string &algorithm,
+           const unsigned rounds,
+           const hash_implementation implementation = hash_implementation::optimized);
+
+    /** Names of all the functions create knows */
+    static std::vector<std::string> algorithms();
+
+private:
+    static std::unique_ptr<hash_interface> create_optimized(const std::string &algorithm,
+                                                            const unsigned rounds);
+    static std::unique_ptr<hash_interface> create_reference(const std::string &algorithm,
+                                                            const unsigned rounds);
 };
 
 } // namespace hash
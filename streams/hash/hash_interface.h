@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace hash {
@@ -16,6 +17,49 @@ struct hash_interface {
 
     virtual int
     Hash(int hash_bitsize, const BitSequence *data, DataLength data_bitsize, BitSequence *hash) = 0;
+
+    /**
+     * Update with whole bytes only. Functions with byte-oriented buffering override this
+     * and skip the partial-byte handling of Update; the default falls back to it.
+     */
+    virtual int update_bytes(const BitSequence *data, DataLength data_bytesize) {
+        return Update(data, 8 * data_bytesize);
+    }
+
+    /**
+     * Raw memory of the hashing context. Functions whose context is self-contained (no pointers,
+     * no state kept elsewhere) expose it, so a copy taken right after Init can be restored
+     * for every next message instead of running Init again. The default opts out.
+     */
+    virtual void *context() { return nullptr; }
+    virtual std::size_t context_size() const { return 0; }
+
+    /**
+     * Number of messages hashed at once by hash_messages. Multi-buffer (SIMD) implementations
+     * return their lane count, a stream gathers its messages for them only when it is above 1.
+     */
+    virtual std::size_t lanes() const { return 1; }
+
+    /**
+     * Hash count messages of message_bytesize bytes stored back to back in data, the digests
+     * are stored back to back in hash as well. The default hashes the messages one by one.
+     */
+    virtual int hash_messages(int hash_bitsize,
+                              const BitSequence *data,
+                              DataLength message_bytesize,
+                              std::size_t count,
+                              BitSequence *hash) {
+        for (std::size_t i = 0; i < count; ++i) {
+            int status = Init(hash_bitsize);
+            if (status == 0)
+                status = update_bytes(data + i * message_bytesize, message_bytesize);
+            if (status == 0)
+                status = Final(hash + i * std::size_t(hash_bitsize / 8));
+            if (status != 0)
+                return status;
+        }
+        return 0;
+    }
 };
 
 } // namespace hash
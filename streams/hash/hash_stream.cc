@@ -3,27 +3,130 @@
 #include "hash_interface.h"
 #include "streams.h"
 #include <algorithm>
+#include <cstring>
 
 namespace hash {
 
+[[noreturn]] static void throw_status(const char *action, const int status) {
+    throw std::runtime_error(std::string("cannot ") + action + " the hash (code: " +
+                             std::to_string(status) + ")");
+}
+
+// "implementation": "reference" selects the reference code of functions with an optimized one
+static std::unique_ptr<hash_interface> create_hasher(const json &config, const unsigned round) {
+    return hash_factory::create(config.at("algorithm"),
+                                round,
+                                _to_implementation(config.value("implementation", "optimized")));
+}
+
+static void init_hash(hash_interface &hasher, const std::size_t hash_size) {
+    // status codes are almost never set, keep the formatting of the message out of line
+    const int status = hasher.Init(int(hash_size * 8));
+    if (status != 0)
+        throw_status("initialize", status);
+}
+
+template <typename I>
+static void hash_initialized(hash_interface &hasher, const I &data, std::uint8_t *hash) {
+    int status = hasher.update_bytes(&(*data.begin()), data.size());
+    if (status != 0)
+        throw_status("update", status);
+
+    status = hasher.Final(hash);
+    if (status != 0)
+        throw_status("finalize", status);
+}
+
 template <typename I>
 void hash_data(hash_interface &hasher,
                const I &data,
                std::uint8_t *hash,
                const std::size_t hash_size) {
-    using std::to_string;
+    init_hash(hasher, hash_size);
+    hash_initialized(hasher, data, hash);
+}
 
-    int status = hasher.Init(int(hash_size * 8));
-    if (status != 0)
-        throw std::runtime_error("cannot initialize hash (code: " + to_string(status) + ")");
+// Init depends only on the hash size, so run it once and keep the resulting context
+static std::vector<std::uint8_t> initial_context(hash_interface &hasher,
+                                                 const std::size_t hash_size) {
+    if (hasher.context_size() == 0)
+        return {};
 
-    status = hasher.Update(&(*data.begin()), 8 * (data.size()));
-    if (status != 0)
-        throw std::runtime_error("cannot update the hash (code: " + to_string(status) + ")");
+    init_hash(hasher, hash_size);
+    auto context = static_cast<const std::uint8_t *>(hasher.context());
+    return {context, context + hasher.context_size()};
+}
 
-    status = hasher.Final(hash);
-    if (status != 0)
-        throw std::runtime_error("cannot finalize the hash (code: " + to_string(status) + ")");
+template <typename I>
+static void hash_message(hash_interface &hasher,
+                         const std::vector<std::uint8_t> &initial_context,
+                         const I &data,
+                         std::uint8_t *hash,
+                         const std::size_t hash_size) {
+    if (initial_context.empty()) {
+        hash_data(hasher, data, hash, hash_size);
+    } else {
+        std::memcpy(hasher.context(), initial_context.data(), initial_context.size());
+        hash_initialized(hasher, data, hash);
+    }
+}
+
+// count next vectors of the source back to back
+static void
+gather_messages(stream &source, const std::size_t count, std::vector<std::uint8_t> &messages) {
+    messages.clear();
+    for (std::size_t i = 0; i < count; ++i) {
+        vec_cview view = source.next();
+        messages.insert(messages.end(), view.begin(), view.end());
+    }
+}
+
+// count messages of length bytes stored back to back, digests stored back to back as well
+static void hash_batch(hash_interface &hasher,
+                       const std::vector<std::uint8_t> &initial_context,
+                       const std::uint8_t *data,
+                       const std::size_t length,
+                       const std::size_t count,
+                       std::uint8_t *hash,
+                       const std::size_t hash_size) {
+    if (hasher.lanes() > 1) {
+        const int status = hasher.hash_messages(int(hash_size * 8), data, length, count, hash);
+        if (status != 0)
+            throw_status("compute", status);
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+        hash_message(hasher,
+                     initial_context,
+                     make_view(data + i * length, length),
+                     &hash[i * hash_size],
+                     hash_size);
+}
+
+// digests of the messages hashed iterations times, the digests of one iteration are the messages
+// of the next one, the two buffers just swap
+static void hash_iterated(hash_interface &hasher,
+                          const std::vector<std::uint8_t> &initial_context,
+                          const std::vector<std::uint8_t> &messages,
+                          const std::size_t count,
+                          const std::size_t iterations,
+                          std::vector<std::uint8_t> &hash,
+                          std::vector<std::uint8_t> &scratch,
+                          const std::size_t hash_size) {
+    hash_batch(hasher,
+               initial_context,
+               messages.data(),
+               messages.size() / count,
+               count,
+               hash.data(),
+               hash_size);
+
+    for (std::size_t i = 1; i < iterations; ++i) {
+        hash_batch(
+            hasher, initial_context, hash.data(), hash_size, count, scratch.data(), hash_size);
+        std::swap(hash, scratch);
+    }
 }
 
 hash_stream::hash_stream(
@@ -39,12 +142,14 @@ hash_stream::hash_stream(
           seeder,
           pipes,
           config.value("input_size", _hash_size))) // if input size is not defined, use hash-size
-    , _hasher(hash_factory::create(config.at("algorithm"), unsigned(_round))) {
+    , _hasher(create_hasher(config, unsigned(_round))) {
     if (osize % _hash_size != 0) {
         // not necessary wrong, but we never needed this, we always did
         // this by mistake. Change to warning if needed
         throw std::runtime_error("Output size is not multiple of hash size");
     }
+
+    _initial_context = initial_context(*_hasher, _hash_size);
     logger::info() << "stream source is hash function: " << config.at("algorithm") << std::endl;
 }
 
@@ -53,13 +158,112 @@ hash_stream::~hash_stream() = default;
 
 vec_cview hash_stream::next() {
     auto hash = _data.data();
+
+    if (_hasher->lanes() > 1 && !_data.empty()) {
+        const std::size_t count = _data.size() / _hash_size;
+
+        gather_messages(*_source, count, _messages);
+        hash_batch(*_hasher,
+                   _initial_context,
+                   _messages.data(),
+                   _messages.size() / count,
+                   count,
+                   hash,
+                   _hash_size);
+        return make_view(_data.cbegin(), osize());
+    }
+
     for (std::size_t i = 0; i < _data.size(); i += _hash_size) {
         vec_cview view = _source->next();
 
-        hash_data(*_hasher, view, &hash[i], _hash_size);
+        hash_message(*_hasher, _initial_context, view, &hash[i], _hash_size);
     }
 
     return make_view(_data.cbegin(), osize());
 }
 
+iterated_hash_stream::iterated_hash_stream(
+    const json &config,
+    default_seed_source &seeder,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+    const std::size_t osize)
+    : stream(osize)
+    , _round(config.at("round"))
+    , _hash_size(std::size_t(config.at("hash_size")))
+    , _iterations(config.at("iterations"))
+    , _source(make_stream(config.at("source"),
+                          seeder,
+                          pipes,
+                          config.value("input_size", _hash_size)))
+    , _hasher(create_hasher(config, unsigned(_round)))
+    , _initial_context(initial_context(*_hasher, _hash_size))
+    , _scratch(osize) {
+    if (osize % _hash_size != 0)
+        throw std::runtime_error("Output size is not multiple of hash size");
+    if (_iterations == 0)
+        throw std::runtime_error("Iterated hash needs at least one iteration");
+    logger::info() << "stream source is hash function: " << config.at("algorithm") << " iterated "
+                   << _iterations << " times" << std::endl;
+}
+
+iterated_hash_stream::iterated_hash_stream(iterated_hash_stream &&) = default;
+iterated_hash_stream::~iterated_hash_stream() = default;
+
+vec_cview iterated_hash_stream::next() {
+    const std::size_t count = _data.size() / _hash_size;
+    if (count == 0)
+        return make_view(_data.cbegin(), osize());
+
+    gather_messages(*_source, count, _messages);
+    hash_iterated(
+        *_hasher, _initial_context, _messages, count, _iterations, _data, _scratch, _hash_size);
+    return make_view(_data.cbegin(), osize());
+}
+
+counter_hash_stream::counter_hash_stream(
+    const json &config,
+    default_seed_source &,
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &,
+    const std::size_t osize)
+    : stream(osize)
+    , _round(config.at("round"))
+    , _hash_size(std::size_t(config.at("hash_size")))
+    , _iterations(config.value("iterations", std::size_t(1)))
+    , _counter(std::make_unique<counter>(config.at("source"),
+                                         config.value("input_size", _hash_size)))
+    , _hasher(create_hasher(config, unsigned(_round)))
+    , _initial_context(initial_context(*_hasher, _hash_size))
+    , _scratch(osize) {
+    if (osize % _hash_size != 0)
+        throw std::runtime_error("Output size is not multiple of hash size");
+    if (_iterations == 0)
+        throw std::runtime_error("Iterated hash needs at least one iteration");
+    logger::info() << "stream source is hash function: " << config.at("algorithm")
+                   << " of a counter" << std::endl;
+}
+
+counter_hash_stream::counter_hash_stream(counter_hash_stream &&) = default;
+counter_hash_stream::~counter_hash_stream() = default;
+
+vec_cview counter_hash_stream::next() {
+    const std::size_t count = _data.size() / _hash_size;
+    if (count == 0)
+        return make_view(_data.cbegin(), osize());
+
+    // the values are written straight into the messages
+    _messages.resize(count * _counter->osize());
+    _counter->next_batch(_messages.data(), count);
+    hash_iterated(
+        *_hasher, _initial_context, _messages, count, _iterations, _data, _scratch, _hash_size);
+    return make_view(_data.cbegin(), osize());
+}
+
+void counter_hash_stream::save_state(std::ostream &out) const {
+    _counter->save_state(out);
+}
+
+void counter_hash_stream::load_state(std::istream &in) {
+    _counter->load_state(in);
+}
+
 } // namespace hash
@@ -5,6 +5,9 @@
 #include <eacirc-core/optional.h>
 #include <eacirc-core/random.h>
 #include <memory>
+#include <vector>
+
+struct counter;
 
 namespace hash {
 
@@ -26,6 +29,10 @@ struct hash_stream : stream {
 
     vec_cview next() override;
 
+    // every message is hashed afresh, the source is all of the state
+    void save_state(std::ostream &out) const override { _source->save_state(out); }
+    void load_state(std::istream &in) override { _source->load_state(in); }
+
 private:
     const std::size_t _round;
     const std::size_t _hash_size;
@@ -33,6 +40,72 @@ private:
     std::unique_ptr<stream> _source;
     stream *_prepared_stream_source;
     std::unique_ptr<hash_interface> _hasher;
+    // context right after Init, restored before every message (empty if not supported)
+    std::vector<std::uint8_t> _initial_context;
+    // messages of one output gathered for multi-buffer functions
+    std::vector<std::uint8_t> _messages;
+};
+
+/**
+ * H^n(x): the hash applied n times ("iterations") on the digest of the previous iteration,
+ * same as n nested hash streams, but without per-level streams and copies between them.
+ */
+struct iterated_hash_stream : stream {
+    iterated_hash_stream(
+        const json &config,
+        default_seed_source &seeder,
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+        const std::size_t osize);
+    iterated_hash_stream(iterated_hash_stream &&);
+    ~iterated_hash_stream() override;
+
+    vec_cview next() override;
+
+    void save_state(std::ostream &out) const override { _source->save_state(out); }
+    void load_state(std::istream &in) override { _source->load_state(in); }
+
+private:
+    const std::size_t _round;
+    const std::size_t _hash_size;
+    const std::size_t _iterations;
+
+    std::unique_ptr<stream> _source;
+    std::unique_ptr<hash_interface> _hasher;
+    std::vector<std::uint8_t> _initial_context;
+    std::vector<std::uint8_t> _messages;
+    // digests of the previous iteration, swapped with _data after every iteration
+    std::vector<std::uint8_t> _scratch;
+};
+
+/**
+ * Fused kernel of a hash stream (iterated "iterations" times) reading a counter, see
+ * compile_stream. The counter writes its values right into the batch of messages, there is no
+ * stream between the two.
+ */
+struct counter_hash_stream : stream {
+    counter_hash_stream(
+        const json &config,
+        default_seed_source &seeder,
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> &pipes,
+        const std::size_t osize);
+    counter_hash_stream(counter_hash_stream &&);
+    ~counter_hash_stream() override;
+
+    vec_cview next() override;
+
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
+private:
+    const std::size_t _round;
+    const std::size_t _hash_size;
+    const std::size_t _iterations;
+
+    std::unique_ptr<counter> _counter;
+    std::unique_ptr<hash_interface> _hasher;
+    std::vector<std::uint8_t> _initial_context;
+    std::vector<std::uint8_t> _messages;
+    std::vector<std::uint8_t> _scratch;
 };
 
 } // namespace hash
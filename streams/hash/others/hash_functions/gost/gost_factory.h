@@ -15,6 +15,9 @@ namespace others {
         Gost(int numRounds = gost_full_rounds);
         int Init(int hash_bitsize);
         int Update(const hash::BitSequence *data, hash::DataLength databitlen);
+        int update_bytes(const hash::BitSequence *data, hash::DataLength databytelen);
+        void *context() { return &m_state; }
+        std::size_t context_size() const { return sizeof(m_state); }
         int Final(hash::BitSequence *hashval);
 
         int Hash(int hashbitlen, const hash::BitSequence *data, hash::DataLength databitlen, hash::BitSequence *hashval);
@@ -0,0 +1,194 @@
+#pragma once
+
+/**
+ * 32-bit words of several independent messages packed in one SIMD register, used by the
+ * multi-buffer variants of the MD-like functions (MD5, SHA-1, SHA-256). Each lane runs the
+ * very same computation as the scalar reference, so reduced rounds stay available. The
+ * operators mirror the scalar ones, so the reference macros apply to the lanes unchanged.
+ *
+ * The widest instruction set enabled at compile time is used: AVX2 (8 lanes, build with
+ * -mavx2 or -march=native), SSE2 (4 lanes, always present on x86-64), otherwise plain
+ * arrays the compiler is free to vectorize.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OTHERS_LANES_SSE2
+#endif
+
+namespace others {
+
+#if defined(__AVX2__)
+
+struct u32_lanes {
+    static constexpr std::size_t count = 8;
+    __m256i v;
+
+    static u32_lanes set1(std::uint32_t x) { return {_mm256_set1_epi32(int(x))}; }
+    static u32_lanes load(const std::uint32_t *x) {
+        return {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(x))};
+    }
+    void store(std::uint32_t *x) const { _mm256_storeu_si256(reinterpret_cast<__m256i *>(x), v); }
+
+    friend u32_lanes operator+(u32_lanes a, u32_lanes b) { return {_mm256_add_epi32(a.v, b.v)}; }
+    friend u32_lanes operator^(u32_lanes a, u32_lanes b) { return {_mm256_xor_si256(a.v, b.v)}; }
+    friend u32_lanes operator&(u32_lanes a, u32_lanes b) { return {_mm256_and_si256(a.v, b.v)}; }
+    friend u32_lanes operator|(u32_lanes a, u32_lanes b) { return {_mm256_or_si256(a.v, b.v)}; }
+    // ~a & b
+    friend u32_lanes andnot(u32_lanes a, u32_lanes b) { return {_mm256_andnot_si256(a.v, b.v)}; }
+    friend u32_lanes operator~(u32_lanes a) { return {_mm256_xor_si256(a.v, _mm256_set1_epi32(-1))}; }
+
+    friend u32_lanes operator>>(u32_lanes a, unsigned n) {
+        return {_mm256_srl_epi32(a.v, _mm_cvtsi32_si128(int(n)))};
+    }
+    friend u32_lanes operator<<(u32_lanes a, unsigned n) {
+        return {_mm256_sll_epi32(a.v, _mm_cvtsi32_si128(int(n)))};
+    }
+};
+
+#elif defined(OTHERS_LANES_SSE2)
+
+struct u32_lanes {
+    static constexpr std::size_t count = 4;
+    __m128i v;
+
+    static u32_lanes set1(std::uint32_t x) { return {_mm_set1_epi32(int(x))}; }
+    static u32_lanes load(const std::uint32_t *x) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i *>(x))};
+    }
+    void store(std::uint32_t *x) const { _mm_storeu_si128(reinterpret_cast<__m128i *>(x), v); }
+
+    friend u32_lanes operator+(u32_lanes a, u32_lanes b) { return {_mm_add_epi32(a.v, b.v)}; }
+    friend u32_lanes operator^(u32_lanes a, u32_lanes b) { return {_mm_xor_si128(a.v, b.v)}; }
+    friend u32_lanes operator&(u32_lanes a, u32_lanes b) { return {_mm_and_si128(a.v, b.v)}; }
+    friend u32_lanes operator|(u32_lanes a, u32_lanes b) { return {_mm_or_si128(a.v, b.v)}; }
+    // ~a & b
+    friend u32_lanes andnot(u32_lanes a, u32_lanes b) { return {_mm_andnot_si128(a.v, b.v)}; }
+    friend u32_lanes operator~(u32_lanes a) { return {_mm_xor_si128(a.v, _mm_set1_epi32(-1))}; }
+
+    friend u32_lanes operator>>(u32_lanes a, unsigned n) {
+        return {_mm_srl_epi32(a.v, _mm_cvtsi32_si128(int(n)))};
+    }
+    friend u32_lanes operator<<(u32_lanes a, unsigned n) {
+        return {_mm_sll_epi32(a.v, _mm_cvtsi32_si128(int(n)))};
+    }
+};
+
+#else
+
+struct u32_lanes {
+    static constexpr std::size_t count = 4;
+    std::uint32_t v[count];
+
+    static u32_lanes set1(std::uint32_t x) { return {{x, x, x, x}}; }
+    static u32_lanes load(const std::uint32_t *x) { return {{x[0], x[1], x[2], x[3]}}; }
+    void store(std::uint32_t *x) const {
+        for (std::size_t i = 0; i < count; ++i)
+            x[i] = v[i];
+    }
+
+    template <typename F> friend u32_lanes map(u32_lanes a, u32_lanes b, F f) {
+        for (std::size_t i = 0; i < count; ++i)
+            a.v[i] = f(a.v[i], b.v[i]);
+        return a;
+    }
+
+    friend u32_lanes operator+(u32_lanes a, u32_lanes b) {
+        return map(a, b, [](std::uint32_t x, std::uint32_t y) { return x + y; });
+    }
+    friend u32_lanes operator^(u32_lanes a, u32_lanes b) {
+        return map(a, b, [](std::uint32_t x, std::uint32_t y) { return x ^ y; });
+    }
+    friend u32_lanes operator&(u32_lanes a, u32_lanes b) {
+        return map(a, b, [](std::uint32_t x, std::uint32_t y) { return x & y; });
+    }
+    friend u32_lanes operator|(u32_lanes a, u32_lanes b) {
+        return map(a, b, [](std::uint32_t x, std::uint32_t y) { return x | y; });
+    }
+    // ~a & b
+    friend u32_lanes andnot(u32_lanes a, u32_lanes b) {
+        return map(a, b, [](std::uint32_t x, std::uint32_t y) { return ~x & y; });
+    }
+    friend u32_lanes operator~(u32_lanes a) { return andnot(a, set1(0xffffffff)); }
+
+    friend u32_lanes operator>>(u32_lanes a, unsigned n) {
+        for (std::size_t i = 0; i < count; ++i)
+            a.v[i] >>= n;
+        return a;
+    }
+    friend u32_lanes operator<<(u32_lanes a, unsigned n) {
+        for (std::size_t i = 0; i < count; ++i)
+            a.v[i] <<= n;
+        return a;
+    }
+};
+
+#endif
+
+inline u32_lanes &operator+=(u32_lanes &a, u32_lanes b) {
+    return a = a + b;
+}
+
+/**
+ * Padded message blocks of u32_lanes::count equally long messages, transposed so that
+ * word i of every lane is loaded at once. Padding follows MD5/SHA: 0x80, zeros and
+ * the 64-bit message length in bits (little endian for MD5, big endian for SHA).
+ */
+template <bool big_endian> struct lanes_message {
+    lanes_message(const std::uint8_t *data, std::size_t length)
+        : _data(data)
+        , _length(length)
+        , _blocks((length + 8) / 64 + 1) {}
+
+    std::size_t blocks() const { return _blocks; }
+
+    // words of block b, w[i] holds word i of all lanes
+    void load_block(std::size_t b, u32_lanes w[16]) const {
+        alignas(32) std::uint32_t words[16][u32_lanes::count];
+        std::uint8_t block[64];
+
+        for (std::size_t lane = 0; lane < u32_lanes::count; ++lane) {
+            fill_block(_data + lane * _length, b, block);
+            for (std::size_t i = 0; i < 16; ++i) {
+                const std::uint8_t *p = block + 4 * i;
+                words[i][lane] = big_endian
+                                     ? std::uint32_t(p[0]) << 24 | std::uint32_t(p[1]) << 16 |
+                                           std::uint32_t(p[2]) << 8 | std::uint32_t(p[3])
+                                     : std::uint32_t(p[3]) << 24 | std::uint32_t(p[2]) << 16 |
+                                           std::uint32_t(p[1]) << 8 | std::uint32_t(p[0]);
+            }
+        }
+        for (std::size_t i = 0; i < 16; ++i)
+            w[i] = u32_lanes::load(words[i]);
+    }
+
+private:
+    void fill_block(const std::uint8_t *message, std::size_t b, std::uint8_t *block) const {
+        const std::size_t begin = b * 64;
+        std::size_t i = 0;
+
+        for (; i < 64 && begin + i < _length; ++i)
+            block[i] = message[begin + i];
+        if (i < 64 && begin + i == _length)
+            block[i++] = 0x80;
+        for (; i < 64; ++i)
+            block[i] = 0x00;
+
+        if (b + 1 == _blocks) {
+            const std::uint64_t bitlen = std::uint64_t(_length) * 8;
+            for (std::size_t j = 0; j < 8; ++j)
+                block[big_endian ? 63 - j : 56 + j] = std::uint8_t(bitlen >> (8 * j));
+        }
+    }
+
+    const std::uint8_t *_data;
+    const std::size_t _length;
+    const std::size_t _blocks;
+};
+
+} // namespace others
@@ -14,6 +14,7 @@
 #include <memory.h>
 #include <algorithm>
 #include "md5.h"
+#include "../lanes.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) ((a << b) | (a >> (32-b)))
@@ -32,29 +33,18 @@
 #define II(a,b,c,d,m,s,t) { a += I(b,c,d) + m + t; \
                             a = b + ROTLEFT(a,s); }
 
-/*********************** FUNCTION DEFINITIONS ***********************/
-void md5_transform(MD5_CTX *ctx, const BYTE data[], unsigned int rounds)
-{
-	WORD a, b, c, d, m[16], i, j;
-
-	// MD5 specifies big endian byte order, but this implementation assumes a little
-	// endian byte order CPU. Reverse all the bytes upon input, and re-reverse them
-	// on output (in md5_final()).
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j]) + (data[j + 1] << 8) + (data[j + 2] << 16) + (data[j + 3] << 24);
-
-
-	static unsigned int index[64] = { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+/**************************** VARIABLES *****************************/
+static const unsigned int md5_index[64] = { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
 					  1,  6, 11,  0,  5, 10, 15,  4,  9, 14,  3,  8, 13,  2,  7, 12,
 					  5,  8, 11, 14,  1,  4,  7, 10, 13,  0,  3,  6,  9, 12, 15,  2,
 					  0,  7, 14,  5, 12,  3, 10,  1,  8, 15,  6, 13,  4, 11,  2,  9};
 
-	static unsigned int padding[64] = { 7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,
+static const unsigned int md5_padding[64] = { 7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,  7, 12, 17, 22,
 					    5,  9, 14, 20,  5,  9, 14, 20,  5,  9, 14, 20,  5,  9, 14, 20,
 					    4, 11, 16, 23,  4, 11, 16, 23,  4, 11, 16, 23,  4, 11, 16, 23,  					    
 					    6, 10, 15, 21,  6, 10, 15, 21,  6, 10, 15, 21,  6, 10, 15, 21};
 
-	static unsigned int table[64] = { 0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+static const unsigned int md5_table[64] = { 0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
 					   0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
 			 	 	   0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
 					   0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
@@ -62,6 +52,18 @@ void md5_transform(MD5_CTX *ctx, const BYTE data[], unsigned int rounds)
 					   0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
 					   0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
 					   0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+/*********************** FUNCTION DEFINITIONS ***********************/
+void md5_transform(MD5_CTX *ctx, const BYTE data[], unsigned int rounds)
+{
+	WORD a, b, c, d, m[16], i, j;
+
+	// MD5 specifies big endian byte order, but this implementation assumes a little
+	// endian byte order CPU. Reverse all the bytes upon input, and re-reverse them
+	// on output (in md5_final()).
+	for (i = 0, j = 0; i < 16; ++i, j += 4)
+		m[i] = (data[j]) + (data[j + 1] << 8) + (data[j + 2] << 16) + (data[j + 3] << 24);
+
 	a = ctx->state[0];
 	b = ctx->state[1];
 	c = ctx->state[2];
@@ -70,16 +72,16 @@ void md5_transform(MD5_CTX *ctx, const BYTE data[], unsigned int rounds)
 	for (unsigned int i = 0; i < rounds; ++i){
 	
 		if (i < 16){
-			FF(a,b,c,d,m[index[i]],padding[i],table[i]);
+			FF(a,b,c,d,m[md5_index[i]],md5_padding[i],md5_table[i]);
 		}
 		if (i >= 16 && i < 32){
-			GG(a,b,c,d,m[index[i]],padding[i],table[i]);
+			GG(a,b,c,d,m[md5_index[i]],md5_padding[i],md5_table[i]);
 		}
 		if (i >= 32 && i < 48){
-			HH(a,b,c,d,m[index[i]],padding[i],table[i]);
+			HH(a,b,c,d,m[md5_index[i]],md5_padding[i],md5_table[i]);
 		}
 		if (i >= 48 && i < 64){
-			II(a,b,c,d,m[index[i]],padding[i],table[i]);
+			II(a,b,c,d,m[md5_index[i]],md5_padding[i],md5_table[i]);
 		}
 
 		std::swap(a,d);
@@ -227,3 +229,73 @@ void md5_final(MD5_CTX *ctx, BYTE hash[], unsigned int rounds)
 		hash[i + 12] = (ctx->state[3] >> (i * 8)) & 0x000000ff;
 	}
 }
+
+/*********************** MULTI-BUFFER VARIANT ***********************/
+// same as md5_transform, for u32_lanes::count independent states at once
+static void md5_transform_lanes(others::u32_lanes state[], const others::u32_lanes m[], unsigned int rounds)
+{
+	others::u32_lanes a, b, c, d;
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+
+	for (unsigned int i = 0; i < rounds; ++i){
+		if (i < 16){
+			FF(a,b,c,d,m[md5_index[i]],md5_padding[i],others::u32_lanes::set1(md5_table[i]));
+		}
+		else if (i < 32){
+			GG(a,b,c,d,m[md5_index[i]],md5_padding[i],others::u32_lanes::set1(md5_table[i]));
+		}
+		else if (i < 48){
+			HH(a,b,c,d,m[md5_index[i]],md5_padding[i],others::u32_lanes::set1(md5_table[i]));
+		}
+		else if (i < 64){
+			II(a,b,c,d,m[md5_index[i]],md5_padding[i],others::u32_lanes::set1(md5_table[i]));
+		}
+		std::swap(a,d);
+		std::swap(b,d);
+		std::swap(c,d);
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+}
+
+void md5_lanes(const BYTE data[], size_t len, size_t count, BYTE hash[], unsigned int rounds)
+{
+	using others::u32_lanes;
+	static const WORD init[4] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476 };
+	size_t n, lane, i, j, b;
+
+	for (n = 0; n + u32_lanes::count <= count; n += u32_lanes::count) {
+		others::lanes_message<false> message(data + n * len, len);
+		u32_lanes state[4], m[16];
+		WORD words[u32_lanes::count];
+
+		for (i = 0; i < 4; ++i)
+			state[i] = u32_lanes::set1(init[i]);
+		for (b = 0; b < message.blocks(); ++b) {
+			message.load_block(b, m);
+			md5_transform_lanes(state, m, rounds);
+		}
+
+		for (i = 0; i < 4; ++i) {
+			state[i].store(words);
+			for (lane = 0; lane < u32_lanes::count; ++lane)
+				for (j = 0; j < 4; ++j)
+					hash[(n + lane) * MD5_BLOCK_SIZE + 4 * i + j] = (words[lane] >> (j * 8)) & 0x000000ff;
+		}
+	}
+
+	// messages not filling all the lanes
+	for ( ; n < count; ++n) {
+		MD5_CTX ctx;
+		md5_init(&ctx);
+		md5_update(&ctx, data + n * len, len, rounds);
+		md5_final(&ctx, hash + n * MD5_BLOCK_SIZE, rounds);
+	}
+}
@@ -36,5 +36,7 @@ typedef struct {
 void md5_init(MD5_CTX *ctx);
 void md5_update(MD5_CTX *ctx, const BYTE data[], size_t len, unsigned int rounds);
 void md5_final(MD5_CTX *ctx, BYTE hash[], unsigned int rounds);
+// hashes count messages of len bytes stored back to back, several of them at once (SIMD lanes)
+void md5_lanes(const BYTE data[], size_t len, size_t count, BYTE hash[], unsigned int rounds);
 
 #endif   // MD5_H
@@ -1,4 +1,5 @@
 #include "md5_factory.h"
+#include "../lanes.h"
 
 namespace others {
 
@@ -12,6 +13,11 @@ int md5_factory::Update(const hash::BitSequence *data, hash::DataLength data_bit
     return 0;
 }
 
+int md5_factory::update_bytes(const hash::BitSequence *data, hash::DataLength data_bytesize) {
+    md5_update(&_ctx, data, data_bytesize, _rounds);
+    return 0;
+}
+
 int md5_factory::Final(hash::BitSequence *others) {
     md5_final(&_ctx, others, _rounds);
     return 0;
@@ -24,4 +30,18 @@ int md5_factory::Hash(int hash_bitsize, const hash::BitSequence *data, hash::Dat
     Final(hash);
     return 0;
 }
+
+std::size_t md5_factory::lanes() const {
+    return u32_lanes::count;
+}
+
+int md5_factory::hash_messages(int hash_bitsize, const hash::BitSequence *data, hash::DataLength message_bytesize,
+                               std::size_t count, hash::BitSequence *hash) {
+    // lanes write whole digests, other sizes take the generic path
+    if (hash_bitsize != 8 * MD5_BLOCK_SIZE)
+        return hash_interface::hash_messages(hash_bitsize, data, message_bytesize, count, hash);
+    md5_lanes(data, message_bytesize, count, hash, _rounds);
+    return 0;
+}
+
 } // namespace others
@@ -30,6 +30,11 @@ namespace others {
         return 0;
     }
 
+    int Ripemd160::update_bytes(const BitSequence *data, DataLength databytelen) {
+        rhash_ripemd160_update(&(this->m_state), data, static_cast<uint32_t>(databytelen), m_rounds);
+        return 0;
+    }
+
     int Ripemd160::Final(BitSequence *hashval) {
         rhash_ripemd160_final(&(this->m_state), hashval, m_rounds);
         return 0;
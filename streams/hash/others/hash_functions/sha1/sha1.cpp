@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <memory.h>
 #include "sha1.h"
+#include "../lanes.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a, b) ((a << b) | (a >> (32 - b)))
@@ -136,3 +137,88 @@ void sha1_final(SHA1_CTX *ctx, BYTE hash[], unsigned int rounds)
 		hash[i + 16] = (ctx->state[4] >> (24 - i * 8)) & 0x000000ff;
 	}
 }
+
+/*********************** MULTI-BUFFER VARIANT ***********************/
+// same as sha1_transform, for u32_lanes::count independent states at once
+static void sha1_transform_lanes(others::u32_lanes state[], const others::u32_lanes data[], const WORD k[], unsigned int rounds)
+{
+	others::u32_lanes a, b, c, d, e, t, m[80];
+	WORD i;
+
+	for (i = 0; i < 16; ++i)
+		m[i] = data[i];
+	for ( ; i < 80; ++i) {
+		m[i] = (m[i - 3] ^ m[i - 8] ^ m[i - 14] ^ m[i - 16]);
+		m[i] = (m[i] << 1) | (m[i] >> 31);
+	}
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+
+	// max 80 rounds
+	if (rounds > 80){
+		rounds = 80;
+	}
+
+	for (i = 0; i < rounds; ++i) {
+		if (i < 20)
+			t = ROTLEFT(a, 5) + ((b & c) ^ (~b & d)) + e + others::u32_lanes::set1(k[0]) + m[i];
+		else if (i < 40)
+			t = ROTLEFT(a, 5) + (b ^ c ^ d) + e + others::u32_lanes::set1(k[1]) + m[i];
+		else if (i < 60)
+			t = ROTLEFT(a, 5) + ((b & c) ^ (b & d) ^ (c & d))  + e + others::u32_lanes::set1(k[2]) + m[i];
+		else
+			t = ROTLEFT(a, 5) + (b ^ c ^ d) + e + others::u32_lanes::set1(k[3]) + m[i];
+		e = d;
+		d = c;
+		c = ROTLEFT(b, 30);
+		b = a;
+		a = t;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+void sha1_lanes(const BYTE data[], size_t len, size_t count, BYTE hash[], unsigned int rounds)
+{
+	using others::u32_lanes;
+	SHA1_CTX ctx;
+	size_t n, lane, i, j, b;
+
+	// initial state and round constants are taken from the reference context
+	sha1_init(&ctx);
+
+	for (n = 0; n + u32_lanes::count <= count; n += u32_lanes::count) {
+		others::lanes_message<true> message(data + n * len, len);
+		u32_lanes state[5], m[16];
+		WORD words[u32_lanes::count];
+
+		for (i = 0; i < 5; ++i)
+			state[i] = u32_lanes::set1(ctx.state[i]);
+		for (b = 0; b < message.blocks(); ++b) {
+			message.load_block(b, m);
+			sha1_transform_lanes(state, m, ctx.k, rounds);
+		}
+
+		for (i = 0; i < 5; ++i) {
+			state[i].store(words);
+			for (lane = 0; lane < u32_lanes::count; ++lane)
+				for (j = 0; j < 4; ++j)
+					hash[(n + lane) * SHA1_BLOCK_SIZE + 4 * i + j] = (words[lane] >> (24 - j * 8)) & 0x000000ff;
+		}
+	}
+
+	// messages not filling all the lanes
+	for ( ; n < count; ++n) {
+		sha1_init(&ctx);
+		sha1_update(&ctx, data + n * len, len, rounds);
+		sha1_final(&ctx, hash + n * SHA1_BLOCK_SIZE, rounds);
+	}
+}
@@ -37,5 +37,7 @@ typedef struct {
 void sha1_init(SHA1_CTX *ctx);
 void sha1_update(SHA1_CTX *ctx, const BYTE data[], size_t len, unsigned int rounds);
 void sha1_final(SHA1_CTX *ctx, BYTE hash[], unsigned int rounds);
+// hashes count messages of len bytes stored back to back, several of them at once (SIMD lanes)
+void sha1_lanes(const BYTE data[], size_t len, size_t count, BYTE hash[], unsigned int rounds);
 
 #endif   // SHA1_H
@@ -1,4 +1,5 @@
 #include "sha1_factory.h"
+#include "../lanes.h"
 
 namespace others{
 
@@ -12,6 +13,11 @@ int sha1_factory::Update(const hash::BitSequence *data, hash::DataLength data_bi
     return 0;
 }
 
+int sha1_factory::update_bytes(const hash::BitSequence *data, hash::DataLength data_bytesize) {
+    sha1_update(& _ctx, data, data_bytesize, _rounds);
+    return 0;
+}
+
 int sha1_factory::Final(hash::BitSequence *others) {
     sha1_final(& _ctx, others, _rounds);
     return 0;
@@ -23,4 +29,18 @@ int sha1_factory::Hash(int hash_bitsize, const hash::BitSequence *data, hash::Da
     Final(hash);
 }
 
+
+std::size_t sha1_factory::lanes() const {
+    return u32_lanes::count;
+}
+
+int sha1_factory::hash_messages(int hash_bitsize, const hash::BitSequence *data, hash::DataLength message_bytesize,
+                                std::size_t count, hash::BitSequence *hash) {
+    // lanes write whole digests, other sizes take the generic path
+    if (hash_bitsize != 8 * SHA1_BLOCK_SIZE)
+        return hash_interface::hash_messages(hash_bitsize, data, message_bytesize, count, hash);
+    sha1_lanes(data, message_bytesize, count, hash, _rounds);
+    return 0;
+}
+
 }
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <memory.h>
 #include "sha256.h"
+#include "../lanes.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
@@ -158,3 +159,86 @@ void sha256_final(SHA256_CTX *ctx, BYTE hash[], unsigned int rounds)
 		hash[i + 28] = (ctx->state[7] >> (24 - i * 8)) & 0x000000ff;
 	}
 }
+
+/*********************** MULTI-BUFFER VARIANT ***********************/
+// same as sha256_transform, for u32_lanes::count independent states at once
+static void sha256_transform_lanes(others::u32_lanes state[], const others::u32_lanes data[], unsigned int rounds)
+{
+	others::u32_lanes a, b, c, d, e, f, g, h, t1, t2, m[64];
+	WORD i;
+
+	for (i = 0; i < 16; ++i)
+		m[i] = data[i];
+	for ( ; i < 64; ++i)
+		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+	f = state[5];
+	g = state[6];
+	h = state[7];
+
+	rounds = (rounds > 64 ? 64 : rounds);
+
+	for (i = 0; i < rounds; ++i) {
+		t1 = h + EP1(e) + CH(e,f,g) + others::u32_lanes::set1(k[i]) + m[i];
+		t2 = EP0(a) + MAJ(a,b,c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void sha256_lanes(const BYTE data[], size_t len, size_t count, BYTE hash[], unsigned int rounds)
+{
+	using others::u32_lanes;
+	static const WORD init[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	size_t n, lane, i, j, b;
+
+	for (n = 0; n + u32_lanes::count <= count; n += u32_lanes::count) {
+		others::lanes_message<true> message(data + n * len, len);
+		u32_lanes state[8], m[16];
+		WORD words[u32_lanes::count];
+
+		for (i = 0; i < 8; ++i)
+			state[i] = u32_lanes::set1(init[i]);
+		for (b = 0; b < message.blocks(); ++b) {
+			message.load_block(b, m);
+			sha256_transform_lanes(state, m, rounds);
+		}
+
+		for (i = 0; i < 8; ++i) {
+			state[i].store(words);
+			for (lane = 0; lane < u32_lanes::count; ++lane)
+				for (j = 0; j < 4; ++j)
+					hash[(n + lane) * SHA256_BLOCK_SIZE + 4 * i + j] = (words[lane] >> (24 - j * 8)) & 0x000000ff;
+		}
+	}
+
+	// messages not filling all the lanes
+	for ( ; n < count; ++n) {
+		SHA256_CTX ctx;
+		sha256_init(&ctx);
+		sha256_update(&ctx, data + n * len, len, rounds);
+		sha256_final(&ctx, hash + n * SHA256_BLOCK_SIZE, rounds);
+	}
+}
@@ -36,5 +36,7 @@ typedef struct {
 void sha256_init(SHA256_CTX *ctx);
 void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len, unsigned int rounds);
 void sha256_final(SHA256_CTX *ctx, BYTE hash[], unsigned int rounds);
+// hashes count messages of len bytes stored back to back, several of them at once (SIMD lanes)
+void sha256_lanes(const BYTE data[], size_t len, size_t count, BYTE hash[], unsigned int rounds);
 
 #endif   // SHA256_H
@@ -1,4 +1,5 @@
 #include "sha256_factory.h"
+#include "../lanes.h"
 
 namespace others{
 
@@ -12,6 +13,11 @@ namespace others{
         return 0;
     }
 
+    int sha256_factory::update_bytes(const hash::BitSequence *data, hash::DataLength data_bytesize) {
+        sha256_update(& _ctx, data, data_bytesize, _rounds);
+        return 0;
+    }
+
     int sha256_factory::Final(hash::BitSequence *others) {
         sha256_final(& _ctx, others, _rounds);
         return 0;
@@ -25,4 +31,18 @@ namespace others{
         return 0;
     }
 
+
+    std::size_t sha256_factory::lanes() const {
+        return u32_lanes::count;
+    }
+
+    int sha256_factory::hash_messages(int hash_bitsize, const hash::BitSequence *data, hash::DataLength message_bytesize,
+                                      std::size_t count, hash::BitSequence *hash) {
+        // lanes write whole digests, other sizes take the generic path
+        if (hash_bitsize != 8 * SHA256_BLOCK_SIZE)
+            return hash_interface::hash_messages(hash_bitsize, data, message_bytesize, count, hash);
+        sha256_lanes(data, message_bytesize, count, hash, _rounds);
+        return 0;
+    }
+
 } // namespace others
@@ -13,6 +13,11 @@ public:
 
     int Init(int others_bitsize) override;
     int Update(const hash::BitSequence* data, hash::DataLength data_bitsize) override;
+    int update_bytes(const hash::BitSequence* data, hash::DataLength data_bytesize) override;
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
+    std::size_t lanes() const override;
+    int hash_messages(int hash_bitsize, const hash::BitSequence* data, hash::DataLength message_bytesize, std::size_t count, hash::BitSequence* hash) override;
     int Final(hash::BitSequence* others) override;
     int Hash(int hash_bitsize, const hash::BitSequence* data, hash::DataLength data_bitsize, hash::BitSequence* hash) override;
 
@@ -33,6 +33,11 @@ int sha3_factory::Update(const hash::BitSequence *data, hash::DataLength data_bi
     return 0;
 }
 
+int sha3_factory::update_bytes(const hash::BitSequence *data, hash::DataLength data_bytesize) {
+    rhash_sha3_update(&_ctx, data, data_bytesize, _rounds);
+    return 0;
+}
+
 int sha3_factory::Final(hash::BitSequence *hash) {
     rhash_sha3_final(&_ctx, hash, _rounds);
     return 0;
@@ -13,6 +13,9 @@ public:
 
     int Init(int bitsize) override;
     int Update(const hash::BitSequence* data, hash::DataLength data_bitsize) override;
+    int update_bytes(const hash::BitSequence* data, hash::DataLength data_bytesize) override;
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
     int Final(hash::BitSequence* hash) override;
     int Hash(int hash_bitsize, const hash::BitSequence* data, hash::DataLength data_bitsize, hash::BitSequence* hash) override;
 
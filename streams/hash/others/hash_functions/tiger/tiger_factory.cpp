@@ -30,6 +30,11 @@ namespace others {
         return 0;
     }
 
+    int Tiger::update_bytes(const BitSequence *data, DataLength databytelen) {
+        rhash_tiger_update(&(this->m_state), data, static_cast<uint32_t>(databytelen), m_rounds);
+        return 0;
+    }
+
     int Tiger::Final(BitSequence *hashval) {
         rhash_tiger_final(&(this->m_state), hashval, m_rounds);
         return 0;
@@ -30,6 +30,11 @@ namespace others {
         return 0;
     }
 
+    int Whirlpool::update_bytes(const BitSequence *data, DataLength databytelen) {
+        rhash_whirlpool_update(&(this->m_state), data, static_cast<uint32_t>(databytelen), m_rounds);
+        return 0;
+    }
+
     int Whirlpool::Final(BitSequence *hashval) {
         rhash_whirlpool_final(&(this->m_state), hashval, m_rounds);
         return 0;
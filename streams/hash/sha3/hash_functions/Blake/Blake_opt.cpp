@@ -0,0 +1,209 @@
+#include "Blake_opt.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLAKE_OPT_SSE2
+#endif
+
+namespace sha3 {
+
+/* permutations of the message words, round r uses r % 10 */
+static const unsigned char blake_opt_sigma[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}};
+
+#ifdef BLAKE_OPT_SSE2
+
+static const unsigned int blake_opt_c32[16] = {
+    0x243F6A88, 0x85A308D3, 0x13198A2E, 0x03707344, 0xA4093822, 0x299F31D0,
+    0x082EFA98, 0xEC4E6C89, 0x452821E6, 0x38D01377, 0xBE5466CF, 0x34E90C6C,
+    0xC0AC29B7, 0xC97C50DD, 0x3F84D5B5, 0xB5470917};
+
+static inline __m128i blake_rotr(__m128i x, int n) {
+    return _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n));
+}
+
+/* message words m[sigma[i]] ^ c[sigma[j]] of the four G functions of a step */
+static inline __m128i
+blake_words(const unsigned int *m, const unsigned char *s, int i0, int i1, int i2, int i3) {
+    return _mm_set_epi32(int(m[s[i3]] ^ blake_opt_c32[s[i3 + 1]]),
+                         int(m[s[i2]] ^ blake_opt_c32[s[i2 + 1]]),
+                         int(m[s[i1]] ^ blake_opt_c32[s[i1 + 1]]),
+                         int(m[s[i0]] ^ blake_opt_c32[s[i0 + 1]]));
+}
+
+static inline __m128i
+blake_words2(const unsigned int *m, const unsigned char *s, int i0, int i1, int i2, int i3) {
+    return _mm_set_epi32(int(m[s[i3 + 1]] ^ blake_opt_c32[s[i3]]),
+                         int(m[s[i2 + 1]] ^ blake_opt_c32[s[i2]]),
+                         int(m[s[i1 + 1]] ^ blake_opt_c32[s[i1]]),
+                         int(m[s[i0 + 1]] ^ blake_opt_c32[s[i0]]));
+}
+
+static inline void blake_g(__m128i &a, __m128i &b, __m128i &c, __m128i &d, __m128i w0, __m128i w1) {
+    a = _mm_add_epi32(_mm_add_epi32(a, b), w0);
+    d = blake_rotr(_mm_xor_si128(d, a), 16);
+    c = _mm_add_epi32(c, d);
+    b = blake_rotr(_mm_xor_si128(b, c), 12);
+    a = _mm_add_epi32(_mm_add_epi32(a, b), w1);
+    d = blake_rotr(_mm_xor_si128(d, a), 8);
+    c = _mm_add_epi32(c, d);
+    b = blake_rotr(_mm_xor_si128(b, c), 7);
+}
+
+int Blake_opt::compress32(const BitSequence *datablock) {
+    unsigned int m[16];
+    for (int i = 0; i < 16; ++i)
+        m[i] = BLAKE_U8TO32_BE(datablock + 4 * i);
+
+    const __m128i h0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(blakeState.h32));
+    const __m128i h1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(blakeState.h32 + 4));
+    const __m128i salt = _mm_loadu_si128(reinterpret_cast<const __m128i *>(blakeState.salt32));
+
+    __m128i a = h0;
+    __m128i b = h1;
+    __m128i c = _mm_xor_si128(salt, _mm_set_epi32(0x03707344, 0x13198A2E, int(0x85A308D3), 0x243F6A88));
+    __m128i d = _mm_set_epi32(int(0xEC4E6C89), 0x082EFA98, 0x299F31D0, int(0xA4093822));
+    if (blakeState.nullt == 0)
+        d = _mm_xor_si128(d, _mm_set_epi32(int(blakeState.t32[1]), int(blakeState.t32[1]),
+                                           int(blakeState.t32[0]), int(blakeState.t32[0])));
+
+    for (int round = 0; round < blakeNumRounds32; ++round) {
+        const unsigned char *s = blake_opt_sigma[round % 10];
+
+        /* columns */
+        blake_g(a, b, c, d, blake_words(m, s, 0, 2, 4, 6), blake_words2(m, s, 0, 2, 4, 6));
+
+        /* diagonals: rotate the rows so the diagonals become columns */
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1));
+        c = _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm_shuffle_epi32(d, _MM_SHUFFLE(2, 1, 0, 3));
+        blake_g(a, b, c, d, blake_words(m, s, 8, 10, 12, 14), blake_words2(m, s, 8, 10, 12, 14));
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3));
+        c = _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));
+        d = _mm_shuffle_epi32(d, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(blakeState.h32),
+                     _mm_xor_si128(_mm_xor_si128(h0, salt), _mm_xor_si128(a, c)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(blakeState.h32 + 4),
+                     _mm_xor_si128(_mm_xor_si128(h1, salt), _mm_xor_si128(b, d)));
+
+    return SUCCESS;
+}
+
+#else
+
+int Blake_opt::compress32(const BitSequence *datablock) {
+    return Blake::compress32(datablock);
+}
+
+#endif
+
+static const unsigned long long blake_opt_c64[16] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL};
+
+static inline unsigned long long blake_rotr64(unsigned long long x, int n) {
+    return (x >> n) | (x << (64 - n));
+}
+
+static inline void blake_g64(unsigned long long &a,
+                             unsigned long long &b,
+                             unsigned long long &c,
+                             unsigned long long &d,
+                             const unsigned long long *m,
+                             const unsigned char *s,
+                             int i) {
+    a += b + (m[s[i]] ^ blake_opt_c64[s[i + 1]]);
+    d = blake_rotr64(d ^ a, 32);
+    c += d;
+    b = blake_rotr64(b ^ c, 25);
+    a += b + (m[s[i + 1]] ^ blake_opt_c64[s[i]]);
+    d = blake_rotr64(d ^ a, 16);
+    c += d;
+    b = blake_rotr64(b ^ c, 11);
+}
+
+/* round R of every ten, its permutation is known when it is compiled */
+template <int R>
+static inline void blake_round64(unsigned long long *v, const unsigned long long *m) {
+    const unsigned char *s = blake_opt_sigma[R];
+    blake_g64(v[0], v[4], v[8], v[12], m, s, 0);
+    blake_g64(v[1], v[5], v[9], v[13], m, s, 2);
+    blake_g64(v[2], v[6], v[10], v[14], m, s, 4);
+    blake_g64(v[3], v[7], v[11], v[15], m, s, 6);
+    blake_g64(v[0], v[5], v[10], v[15], m, s, 8);
+    blake_g64(v[1], v[6], v[11], v[12], m, s, 10);
+    blake_g64(v[2], v[7], v[8], v[13], m, s, 12);
+    blake_g64(v[3], v[4], v[9], v[14], m, s, 14);
+}
+
+int Blake_opt::compress64(const BitSequence *datablock) {
+    unsigned long long m[16];
+    for (int i = 0; i < 16; ++i)
+        m[i] = BLAKE_U8TO64_BE(datablock + 8 * i);
+
+    unsigned long long v[16];
+    for (int i = 0; i < 8; ++i)
+        v[i] = blakeState.h64[i];
+    for (int i = 0; i < 4; ++i)
+        v[8 + i] = blakeState.salt64[i] ^ blake_opt_c64[i];
+    for (int i = 0; i < 4; ++i)
+        v[12 + i] = blake_opt_c64[4 + i];
+    if (blakeState.nullt == 0) {
+        v[12] ^= blakeState.t64[0];
+        v[13] ^= blakeState.t64[0];
+        v[14] ^= blakeState.t64[1];
+        v[15] ^= blakeState.t64[1];
+    }
+
+    /* ten rounds unrolled, the last pass stops after the rounds left */
+    for (int left = blakeNumRounds64; left > 0; left -= 10) {
+        blake_round64<0>(v, m);
+        if (left == 1)
+            break;
+        blake_round64<1>(v, m);
+        if (left == 2)
+            break;
+        blake_round64<2>(v, m);
+        if (left == 3)
+            break;
+        blake_round64<3>(v, m);
+        if (left == 4)
+            break;
+        blake_round64<4>(v, m);
+        if (left == 5)
+            break;
+        blake_round64<5>(v, m);
+        if (left == 6)
+            break;
+        blake_round64<6>(v, m);
+        if (left == 7)
+            break;
+        blake_round64<7>(v, m);
+        if (left == 8)
+            break;
+        blake_round64<8>(v, m);
+        if (left == 9)
+            break;
+        blake_round64<9>(v, m);
+    }
+
+    for (int i = 0; i < 8; ++i)
+        blakeState.h64[i] ^= v[i] ^ v[8 + i] ^ blakeState.salt64[i % 4];
+
+    return SUCCESS;
+}
+
+} // namespace sha3
@@ -0,0 +1,26 @@
+#ifndef BLAKE_OPT_H
+#define BLAKE_OPT_H
+
+#include "Blake_sha3.h"
+
+namespace sha3 {
+
+/*
+ * BLAKE-32 compression with the four rows of the state in SSE2 registers, so the four G
+ * functions of a column (or diagonal) step run at once; the diagonal step rotates the rows
+ * instead of indexing. Without SSE2 it keeps the reference compression. BLAKE-64 (hashes over
+ * 256 bits) has its ten rounds unrolled, their message words are picked when it is compiled.
+ */
+class Blake_opt : public Blake {
+public:
+    Blake_opt(const int numRounds)
+        : Blake(numRounds) {}
+
+protected:
+    int compress32(const BitSequence *datablock) override;
+    int compress64(const BitSequence *datablock) override;
+};
+
+} // namespace sha3
+
+#endif
@@ -541,6 +541,60 @@ int Blake::Update(const BitSequence * data, DataLength databitlen ) {
     return Update64( data, databitlen );
 }
 
+/* same as Update32/Update64, but counting in whole bytes (no trailing bits) */
+int Blake::update_bytes( const BitSequence * data, DataLength databytelen ) {
+
+  const int wide = blakeState.hashbitlen >= 384;
+  const DataLength blockbytes = wide ? 128 : 64;
+  BitSequence * buffer = wide ? blakeState.data64 : blakeState.data32;
+  DataLength left = blakeState.datalen >> 3;
+  DataLength fill = blockbytes - left;
+
+  if ( ( databytelen == 0 ) && ( DataLength(blakeState.datalen) != ( blockbytes << 3 ) ) )
+    return SUCCESS;
+
+  /* compress remaining data filled with new bytes */
+  if( left && ( ( databytelen & ( blockbytes - 1 ) ) >= fill ) ) {
+    memcpy( (void *) (buffer + left), (void *) data, fill );
+    if ( wide ) {
+      blakeState.t64[0] += 1024;
+      compress64( buffer );
+    } else {
+      blakeState.t32[0] += 512;
+      if (blakeState.t32[0] == 0)
+        blakeState.t32[1]++;
+      compress32( buffer );
+    }
+    data += fill;
+    databytelen -= fill;
+    left = 0;
+  }
+
+  /* compress data until enough for a block */
+  while( databytelen >= blockbytes ) {
+    if ( wide ) {
+      blakeState.t64[0] += 1024;
+      compress64( data );
+    } else {
+      blakeState.t32[0] += 512;
+      if (blakeState.t32[0] == 0)
+        blakeState.t32[1]++;
+      compress32( data );
+    }
+    data += blockbytes;
+    databytelen -= blockbytes;
+  }
+
+  if( databytelen > 0 ) {
+    memcpy( (void *) (buffer + left), (void *) data, databytelen );
+    blakeState.datalen = int( ( left + databytelen ) << 3 );
+  }
+  else
+    blakeState.datalen = 0;
+
+  return SUCCESS;
+}
+
 
 int Blake::Final32( BitSequence * hashval ) {
 
@@ -6,6 +6,7 @@
 namespace sha3 {
 
 class Blake : public sha3_interface {
+protected:
 
 //NASTAVENIE RUND:
 #define BLAKE_NB_ROUNDS32 14
@@ -67,7 +68,7 @@ typedef struct  {
   unsigned long long salt64[4];   /* salt (null by default) */
 } hashState;
 
-private:
+protected:
 int blakeNumRounds32;
 int blakeNumRounds64;
 hashState blakeState;
@@ -76,14 +77,18 @@ public:
 Blake( const int numRounds );
 int Init( int hashbitlen );
 int Update( const BitSequence * data, DataLength databitlen );
+int update_bytes( const BitSequence * data, DataLength databytelen );
+void *context() { return &blakeState; }
+size_t context_size() const { return sizeof(blakeState); }
 int Final( BitSequence * hashval );
 int Hash( int hashbitlen, const BitSequence * data, DataLength databitlen, 
 		 BitSequence * hashval );
 
-private:
+protected:
 int AddSalt( const BitSequence * salt );
-int compress32( const BitSequence * datablock );
-int compress64( const BitSequence * datablock );
+/* compression functions, optimized variants override them */
+virtual int compress32( const BitSequence * datablock );
+virtual int compress64( const BitSequence * datablock );
 int Update32( const BitSequence * data, DataLength databitlen );
 int Update64( const BitSequence * data, DataLength databitlen );
 int Final32( BitSequence * hashval );
@@ -0,0 +1,78 @@
+#include "CubeHash_opt.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CUBEHASH_OPT_SSE2
+#endif
+
+namespace sha3 {
+
+#ifdef CUBEHASH_OPT_SSE2
+
+static inline __m128i cubehash_rotl(__m128i x, int n) {
+    return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+}
+
+void Cubehash_opt::transform() {
+    __m128i *x = reinterpret_cast<__m128i *>(cubehashState.x);
+    __m128i a0 = _mm_loadu_si128(x + 0), a1 = _mm_loadu_si128(x + 1);
+    __m128i a2 = _mm_loadu_si128(x + 2), a3 = _mm_loadu_si128(x + 3);
+    __m128i b0 = _mm_loadu_si128(x + 4), b1 = _mm_loadu_si128(x + 5);
+    __m128i b2 = _mm_loadu_si128(x + 6), b3 = _mm_loadu_si128(x + 7);
+    __m128i t0, t1;
+
+    for (int r = 0; r < cubehashNumRounds; ++r) {
+        b0 = _mm_add_epi32(b0, a0);
+        b1 = _mm_add_epi32(b1, a1);
+        b2 = _mm_add_epi32(b2, a2);
+        b3 = _mm_add_epi32(b3, a3);
+        // x[i ^ 8] <<<= 7: swap the halves of x[0..15]
+        t0 = cubehash_rotl(a0, 7);
+        t1 = cubehash_rotl(a1, 7);
+        a0 = _mm_xor_si128(cubehash_rotl(a2, 7), b0);
+        a1 = _mm_xor_si128(cubehash_rotl(a3, 7), b1);
+        a2 = _mm_xor_si128(t0, b2);
+        a3 = _mm_xor_si128(t1, b3);
+        // x[16 + (i ^ 2)]: swap the word pairs within a vector
+        b0 = _mm_shuffle_epi32(b0, _MM_SHUFFLE(1, 0, 3, 2));
+        b1 = _mm_shuffle_epi32(b1, _MM_SHUFFLE(1, 0, 3, 2));
+        b2 = _mm_shuffle_epi32(b2, _MM_SHUFFLE(1, 0, 3, 2));
+        b3 = _mm_shuffle_epi32(b3, _MM_SHUFFLE(1, 0, 3, 2));
+
+        b0 = _mm_add_epi32(b0, a0);
+        b1 = _mm_add_epi32(b1, a1);
+        b2 = _mm_add_epi32(b2, a2);
+        b3 = _mm_add_epi32(b3, a3);
+        // x[i ^ 4] <<<= 11: swap neighbouring vectors
+        t0 = cubehash_rotl(a0, 11);
+        a0 = _mm_xor_si128(cubehash_rotl(a1, 11), b0);
+        a1 = _mm_xor_si128(t0, b1);
+        t0 = cubehash_rotl(a2, 11);
+        a2 = _mm_xor_si128(cubehash_rotl(a3, 11), b2);
+        a3 = _mm_xor_si128(t0, b3);
+        // x[16 + (i ^ 1)]: swap the neighbouring words within a vector
+        b0 = _mm_shuffle_epi32(b0, _MM_SHUFFLE(2, 3, 0, 1));
+        b1 = _mm_shuffle_epi32(b1, _MM_SHUFFLE(2, 3, 0, 1));
+        b2 = _mm_shuffle_epi32(b2, _MM_SHUFFLE(2, 3, 0, 1));
+        b3 = _mm_shuffle_epi32(b3, _MM_SHUFFLE(2, 3, 0, 1));
+    }
+
+    _mm_storeu_si128(x + 0, a0);
+    _mm_storeu_si128(x + 1, a1);
+    _mm_storeu_si128(x + 2, a2);
+    _mm_storeu_si128(x + 3, a3);
+    _mm_storeu_si128(x + 4, b0);
+    _mm_storeu_si128(x + 5, b1);
+    _mm_storeu_si128(x + 6, b2);
+    _mm_storeu_si128(x + 7, b3);
+}
+
+#else
+
+void Cubehash_opt::transform() {
+    Cubehash::transform();
+}
+
+#endif
+
+} // namespace sha3
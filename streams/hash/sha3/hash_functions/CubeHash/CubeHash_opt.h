@@ -0,0 +1,24 @@
+#ifndef CUBEHASH_OPT_H
+#define CUBEHASH_OPT_H
+
+#include "CubeHash_sha3.h"
+
+namespace sha3 {
+
+/*
+ * CubeHash with the state held in SSE2 registers for the whole transform: the 32 words are
+ * four vectors of x[0..15] and four of x[16..31], the word permutations of a round become
+ * vector swaps and shuffles. Without SSE2 the reference round function is used.
+ */
+class Cubehash_opt : public Cubehash {
+public:
+    Cubehash_opt(const int numRounds)
+        : Cubehash(numRounds) {}
+
+protected:
+    void transform() override;
+};
+
+} // namespace sha3
+
+#endif
@@ -48,35 +48,45 @@ int Cubehash::Init(int hashbitlen)
   cubehashState.x[0] = hashbitlen / 8;
   cubehashState.x[1] = CUBEHASH_BLOCKBYTES;
   cubehashState.x[2] = cubehashNumRounds;
-  for (i = 0;i < 10;++i) Cubehash::transform();
+  for (i = 0;i < 10;++i) transform();
   cubehashState.pos = 0;
   return SUCCESS;
 }
 
 int Cubehash::Update(const BitSequence *data,
                   DataLength databitlen)
+{
+  Cubehash::update_bytes(data,databitlen / 8);
+  data += databitlen / 8;
+  databitlen %= 8;
+
+  if (databitlen > 0) {
+    cubehash_myuint32 u = *data;
+    u <<= 8 * ((cubehashState.pos / 8) % 4);
+    cubehashState.x[cubehashState.pos / 32] ^= u;
+    cubehashState.pos += databitlen;
+  }
+  return SUCCESS;
+}
+
+int Cubehash::update_bytes(const BitSequence *data,
+                  DataLength databytelen)
 {
   /* caller promises us that previous data had integral number of bytes */
   /* so cubehashState.pos is a multiple of 8 */
 
-  while (databitlen >= 8) {
+  while (databytelen > 0) {
     cubehash_myuint32 u = *data;
     u <<= 8 * ((cubehashState.pos / 8) % 4);
     cubehashState.x[cubehashState.pos / 32] ^= u;
     data += 1;
-    databitlen -= 8;
+    databytelen -= 1;
     cubehashState.pos += 8;
     if (cubehashState.pos == 8 * CUBEHASH_BLOCKBYTES) {
-      Cubehash::transform();
+      transform();
       cubehashState.pos = 0;
     }
   }
-  if (databitlen > 0) {
-    cubehash_myuint32 u = *data;
-    u <<= 8 * ((cubehashState.pos / 8) % 4);
-    cubehashState.x[cubehashState.pos / 32] ^= u;
-    cubehashState.pos += databitlen;
-  }
   return SUCCESS;
 }
 
@@ -88,9 +98,9 @@ int Cubehash::Final(BitSequence *hashval)
   u = (128 >> (cubehashState.pos % 8));
   u <<= 8 * ((cubehashState.pos / 8) % 4);
   cubehashState.x[cubehashState.pos / 32] ^= u;
-  Cubehash::transform();
+  transform();
   cubehashState.x[31] ^= 1;
-  for (i = 0;i < 10;++i) Cubehash::transform();
+  for (i = 0;i < 10;++i) transform();
   for (i = 0;i < cubehashState.hashbitlen / 8;++i) hashval[i] = cubehashState.x[i / 4] >> (8 * (i % 4));
 
   return SUCCESS;
@@ -6,6 +6,7 @@
 namespace sha3 {
 
 class Cubehash : public sha3_interface {
+protected:
 
 //NASTAVENIE RUND:
 #define CUBEHASH_ROUNDS 8
@@ -23,7 +24,7 @@ typedef struct {
   cubehash_myuint32 x[32];
 } hashState;
 
-private:
+protected:
 int cubehashNumRounds;
 hashState cubehashState;
 
@@ -32,12 +33,17 @@ Cubehash(const int numRounds);
 int Init(int hashbitlen);
 int Update(const BitSequence *data,
                   DataLength databitlen);
+int update_bytes(const BitSequence *data,
+                  DataLength databytelen);
+void *context() { return &cubehashState; }
+size_t context_size() const { return sizeof(cubehashState); }
 int Final(BitSequence *hashval);
 int Hash(int hashbitlen, const BitSequence *data,
                 DataLength databitlen, BitSequence *hashval);
 
-private:
-void transform();
+protected:
+/* the round function, optimized variants override it */
+virtual void transform();
 
 };
 
@@ -0,0 +1,147 @@
+#include "Grostl_opt.h"
+#include "tables.h"
+#include <string.h>
+
+namespace sha3 {
+
+#if (PLATFORM_BYTE_ORDER == IS_LITTLE_ENDIAN)
+
+namespace {
+
+/* row r of a column is its byte r */
+struct grostl_t64 {
+    grostl_u64 t[8][256];
+
+    grostl_t64() {
+        for (int j = 0; j < 8; ++j)
+            for (int b = 0; b < 256; ++b)
+                t[j][b] = grostl_u64(GROSTL_T[j * 256 + b]) |
+                          grostl_u64(GROSTL_T[((j + 4) % 8) * 256 + b]) << 32;
+    }
+};
+
+const grostl_t64 grostl_table;
+
+/* byte shifts of the rows, P and Q of the short and the long variants */
+const int grostl_shift_p512[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+const int grostl_shift_q512[8] = {1, 3, 5, 7, 0, 2, 4, 6};
+const int grostl_shift_p1024[8] = {0, 1, 2, 3, 4, 5, 6, 11};
+const int grostl_shift_q1024[8] = {1, 3, 5, 11, 0, 2, 4, 6};
+
+/* one round of P (q == false) or Q on cols columns, x is modified by the round constant */
+template <int cols, bool q>
+inline void grostl_round(grostl_u64 *x, grostl_u64 *y, grostl_u8 r, const int *shift) {
+    for (int c = 0; c < cols; ++c) {
+        if (q)
+            x[c] ^= ~grostl_u64(0) ^ (grostl_u64((c << 4) ^ r) << 56);
+        else
+            x[c] ^= grostl_u64((c << 4) ^ r);
+    }
+    for (int c = 0; c < cols; ++c) {
+        grostl_u64 column = 0;
+        for (int row = 0; row < 8; ++row)
+            column ^= grostl_table.t[row][grostl_u8(x[(c + shift[row]) % cols] >> (8 * row))];
+        y[c] = column;
+    }
+}
+
+/* the reference order of round constants: 0, 1, ..., rounds - 2 and the given last one,
+   the constants are a byte (the reference shifts a wrapped around rounds - 1 into one) */
+template <int cols, bool q>
+inline void grostl_permutation(grostl_u64 *x, int rounds, grostl_u8 last) {
+    const int *shift = cols == 8 ? (q ? grostl_shift_q512 : grostl_shift_p512)
+                                 : (q ? grostl_shift_q1024 : grostl_shift_p1024);
+    grostl_u64 y[cols];
+    grostl_u64 z[cols];
+
+    grostl_round<cols, q>(x, y, 0, shift);
+    for (int i = 1; i < rounds - 1; i += 2) {
+        grostl_round<cols, q>(y, z, grostl_u8(i), shift);
+        grostl_round<cols, q>(z, y, grostl_u8(i + 1), shift);
+    }
+    grostl_round<cols, q>(y, x, last, shift);
+}
+
+template <int cols> inline void grostl_compress(grostl_u64 *h, const grostl_u8 *m, int rounds) {
+    grostl_u64 p[cols];
+    grostl_u64 q[cols];
+
+    memcpy(q, m, sizeof(q));
+    for (int c = 0; c < cols; ++c)
+        p[c] = h[c] ^ q[c];
+
+    grostl_permutation<cols, true>(q, rounds, grostl_u8(cols == 8 ? rounds - 1 : 13));
+    grostl_permutation<cols, false>(p, rounds, grostl_u8(rounds - 1));
+
+    for (int c = 0; c < cols; ++c)
+        h[c] ^= p[c] ^ q[c];
+}
+
+} // namespace
+
+void Grostl_opt::Transform(hashState *ctx,
+                           const grostl_u8 *input,
+                           int msglen,
+                           const int rounds512,
+                           const int rounds1024) {
+    if (ctx->v == SHORT && rounds512 < GROSTL_ROUNDS512) {
+        Grostl::Transform(ctx, input, msglen, rounds512, rounds1024);
+        return;
+    }
+
+    grostl_u64 h[GROSTL_COLS1024];
+    memcpy(h, ctx->chaining, ctx->statesize);
+
+    for (; msglen >= ctx->statesize; msglen -= ctx->statesize, input += ctx->statesize) {
+        if (ctx->v == SHORT)
+            grostl_compress<GROSTL_COLS512>(h, input, GROSTL_ROUNDS512);
+        else
+            grostl_compress<GROSTL_COLS1024>(h, input, rounds1024);
+
+        /* increment block counter */
+        ctx->block_counter1++;
+        if (ctx->block_counter1 == 0)
+            ctx->block_counter2++;
+    }
+
+    memcpy(ctx->chaining, h, ctx->statesize);
+}
+
+void Grostl_opt::OutputTransformation(hashState *ctx, const int rounds512, const int rounds1024) {
+    if (ctx->v == SHORT && rounds512 < GROSTL_ROUNDS512) {
+        Grostl::OutputTransformation(ctx, rounds512, rounds1024);
+        return;
+    }
+
+    grostl_u64 h[GROSTL_COLS1024];
+    grostl_u64 p[GROSTL_COLS1024];
+    memcpy(h, ctx->chaining, ctx->statesize);
+    memcpy(p, h, ctx->statesize);
+
+    if (ctx->v == SHORT)
+        grostl_permutation<GROSTL_COLS512, false>(p, GROSTL_ROUNDS512, GROSTL_ROUNDS512 - 1);
+    else
+        grostl_permutation<GROSTL_COLS1024, false>(p, rounds1024, grostl_u8(rounds1024 - 1));
+
+    for (int c = 0; c < ctx->columns; ++c)
+        h[c] ^= p[c];
+    memcpy(ctx->chaining, h, ctx->statesize);
+}
+
+#else
+
+void Grostl_opt::Transform(hashState *ctx,
+                           const grostl_u8 *input,
+                           int msglen,
+                           const int rounds512,
+                           const int rounds1024) {
+    Grostl::Transform(ctx, input, msglen, rounds512, rounds1024);
+}
+
+void Grostl_opt::OutputTransformation(hashState *ctx, const int rounds512, const int rounds1024) {
+    Grostl::OutputTransformation(ctx, rounds512, rounds1024);
+}
+
+#endif
+
+} // namespace sha3
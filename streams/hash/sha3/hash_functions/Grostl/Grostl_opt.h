@@ -0,0 +1,31 @@
+#ifndef GROSTL_OPT_H
+#define GROSTL_OPT_H
+
+#include "Grostl_sha3.h"
+
+namespace sha3 {
+
+/*
+ * Groestl on 64-bit columns: one lookup in a 64-bit table gives a whole column contribution
+ * of a byte, where the reference needs two 32-bit lookups, and P and Q run on stack arrays
+ * without the allocations of the reference output transformation. The short variant with
+ * less than 10 rounds stays on the reference, which applies its rounds in its own way there.
+ * Little-endian platforms only, big-endian ones use the reference.
+ */
+class Grostl_opt : public Grostl {
+public:
+    Grostl_opt(const int numRounds)
+        : Grostl(numRounds) {}
+
+protected:
+    void Transform(hashState *ctx,
+                   const grostl_u8 *input,
+                   int msglen,
+                   const int rounds512,
+                   const int rounds1024) override;
+    void OutputTransformation(hashState *ctx, const int rounds512, const int rounds1024) override;
+};
+
+} // namespace sha3
+
+#endif
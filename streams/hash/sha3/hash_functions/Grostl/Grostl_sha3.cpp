@@ -1,5 +1,6 @@
 #include "Grostl_sha3.h"
 #include "tables.h"
+#include <string.h>
 
 namespace sha3 {
 
@@ -377,11 +378,9 @@ int Grostl::Init(int hashbitlen) {
     grostlState.v = LONG;
   }
 
-  /* allocate memory for state and data buffer */
-  grostlState.chaining = (grostl_uint_32t *) calloc(grostlState.statesize,1);
-  grostlState.buffer = (BitSequence *) malloc(grostlState.statesize);
-  if (grostlState.chaining == NULL || grostlState.buffer == NULL)
-    return FAIL;
+  /* state and data buffer are part of the context (no allocation, so
+     the initialised context can be copied and restored by value) */
+  memset(grostlState.chaining, 0, grostlState.statesize);
 
   /* set initial value */
   grostlState.chaining[2*grostlState.columns-1] = GROSTL_U32BIG((grostl_u32)hashbitlen);
@@ -399,10 +398,30 @@ int Grostl::Init(int hashbitlen) {
 /* update state with databitlen bits of input */
 int Grostl::Update(const BitSequence* input,
 		  DataLength databitlen) {
-  int index = 0;
   int msglen = (int)(databitlen/8);
   int rem = (int)(databitlen%8);
 
+  /* digest all whole bytes, this fails if a partial byte was
+     already supplied */
+  int ret = Grostl::update_bytes(input, databitlen/8);
+  if (ret != SUCCESS) return ret;
+
+  /* if non-integral number of bytes have been supplied, store
+     remaining bits in last byte, together with information about
+     number of bits */
+  if (rem) {
+    grostlState.bits_in_last_byte = rem;
+    grostlState.buffer[(int)grostlState.buf_ptr++] = input[msglen];
+  }
+  return SUCCESS;
+}
+
+/* update state with whole bytes only */
+int Grostl::update_bytes(const BitSequence* input,
+		  DataLength databytelen) {
+  int index = 0;
+  int msglen = (int)databytelen;
+
   /* non-integral number of message bytes can only be supplied in the
      last call to this function */
   if (grostlState.bits_in_last_byte) return FAIL;
@@ -415,10 +434,6 @@ int Grostl::Update(const BitSequence* input,
     }
     if (grostlState.buf_ptr < grostlState.statesize) {
       /* buffer still not full, return */
-      if (rem) {
-	grostlState.bits_in_last_byte = rem;
-	grostlState.buffer[(int)grostlState.buf_ptr++] = input[index];
-      }
       return SUCCESS;
     }
 
@@ -436,13 +451,6 @@ int Grostl::Update(const BitSequence* input,
     grostlState.buffer[(int)grostlState.buf_ptr++] = input[index++];
   }
 
-  /* if non-integral number of bytes have been supplied, store
-     remaining bits in last byte, together with information about
-     number of bits */
-  if (rem) {
-    grostlState.bits_in_last_byte = rem;
-    grostlState.buffer[(int)grostlState.buf_ptr++] = input[index];
-  }
   return SUCCESS;
 }
 
@@ -500,15 +508,13 @@ int Grostl::Final(BitSequence* output) {
     output[j] = s[i];
   }
 
-  /* zeroise relevant variables and deallocate memory */
+  /* zeroise relevant variables */
   for (i = 0; i < grostlState.columns; i++) {
     grostlState.chaining[i] = 0;
   }
   for (i = 0; i < grostlState.statesize; i++) {
     grostlState.buffer[i] = 0;
   }
-  free(grostlState.chaining);
-  free(grostlState.buffer);
 
   return SUCCESS;
 }
@@ -10,6 +10,7 @@
 namespace sha3 {
 
 class Grostl : public sha3_interface {
+protected:
 
 /* some sizes (number of bytes) */
 #define GROSTL_ROWS 8
@@ -43,11 +44,11 @@ typedef enum { LONG, SHORT } Var;
 /* NIST API begin */
 typedef enum { SUCCESS = 0, FAIL = 1, BAD_HASHLEN = 2 } HashReturn;
 typedef struct {
-  grostl_u32 *chaining;            /* actual state */
+  grostl_u32 chaining[GROSTL_SIZE1024/4]; /* actual state */
   grostl_u32 block_counter1,
     block_counter2;         /* message block counter(s) */
   int hashbitlen;           /* output length in bits */
-  BitSequence *buffer;      /* data buffer */
+  BitSequence buffer[GROSTL_SIZE1024]; /* data buffer */
   int buf_ptr;              /* data buffer pointer */
   int bits_in_last_byte;    /* no. of message bits in last byte of
 			       data buffer */
@@ -56,7 +57,7 @@ typedef struct {
   Var v;                    /* LONG or SHORT */
 } hashState;
 
-private:
+protected:
 int grostlNumRounds512;
 int grostlNumRounds1024;
 hashState grostlState;
@@ -65,15 +66,18 @@ public:
 Grostl(const int numRounds);
 int Init(int);
 int Update(const BitSequence*, DataLength);
+int update_bytes(const BitSequence*, DataLength);
+void *context() { return &grostlState; }
+size_t context_size() const { return sizeof(grostlState); }
 int Final(BitSequence*);
 int Hash(int, const BitSequence*, DataLength, BitSequence*);
 /* NIST API end   */
 
-/* helper functions */
-private:
+/* helper functions, optimized variants override the transformations */
+protected:
 void PrintHash(const BitSequence*, int);
-void Transform(hashState *ctx, const grostl_u8 *input, int msglen, const int rounds512, const int rounds1024);
-void OutputTransformation(hashState *ctx, const int rounds512, const int rounds1024);
+virtual void Transform(hashState *ctx, const grostl_u8 *input, int msglen, const int rounds512, const int rounds1024);
+virtual void OutputTransformation(hashState *ctx, const int rounds512, const int rounds1024);
 
 };
 
@@ -0,0 +1,117 @@
+#include "JH_opt.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JH_OPT_SSE2
+#endif
+
+namespace sha3 {
+
+#ifdef JH_OPT_SSE2
+
+/* swap the neighbouring groups of n bits selected by mask and its complement */
+static inline __m128i jh_swap(__m128i x, __m128i mask, int n) {
+    return _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, mask), n),
+                        _mm_srli_epi32(_mm_andnot_si128(mask, x), n));
+}
+
+static inline void jh_sbox(__m128i &m0, __m128i &m1, __m128i &m2, __m128i &m3, __m128i cc) {
+    __m128i temp0;
+    m3 = _mm_xor_si128(m3, _mm_set1_epi32(-1));
+    m0 = _mm_xor_si128(m0, _mm_andnot_si128(m2, cc));
+    temp0 = _mm_xor_si128(cc, _mm_and_si128(m0, m1));
+    m0 = _mm_xor_si128(m0, _mm_and_si128(m2, m3));
+    m3 = _mm_xor_si128(m3, _mm_andnot_si128(m1, m2));
+    m1 = _mm_xor_si128(m1, _mm_and_si128(m0, m2));
+    m2 = _mm_xor_si128(m2, _mm_andnot_si128(m3, m0));
+    m0 = _mm_xor_si128(m0, _mm_or_si128(m1, m3));
+    m3 = _mm_xor_si128(m3, _mm_and_si128(m1, m2));
+    m1 = _mm_xor_si128(m1, _mm_and_si128(temp0, m0));
+    m2 = _mm_xor_si128(m2, temp0);
+}
+
+static inline void jh_l(__m128i &m0, __m128i &m1, __m128i &m2, __m128i &m3,
+                        __m128i &m4, __m128i &m5, __m128i &m6, __m128i &m7) {
+    m4 = _mm_xor_si128(m4, m1);
+    m5 = _mm_xor_si128(m5, m2);
+    m6 = _mm_xor_si128(m6, _mm_xor_si128(m0, m3));
+    m7 = _mm_xor_si128(m7, m0);
+    m0 = _mm_xor_si128(m0, m5);
+    m1 = _mm_xor_si128(m1, m6);
+    m2 = _mm_xor_si128(m2, _mm_xor_si128(m4, m7));
+    m3 = _mm_xor_si128(m3, m4);
+}
+
+void JH_opt::E8() {
+    __m128i *state = reinterpret_cast<__m128i *>(jhState.x);
+    __m128i x0 = _mm_loadu_si128(state + 0), x1 = _mm_loadu_si128(state + 1);
+    __m128i x2 = _mm_loadu_si128(state + 2), x3 = _mm_loadu_si128(state + 3);
+    __m128i x4 = _mm_loadu_si128(state + 4), x5 = _mm_loadu_si128(state + 5);
+    __m128i x6 = _mm_loadu_si128(state + 6), x7 = _mm_loadu_si128(state + 7);
+
+    const __m128i mask1 = _mm_set1_epi32(0x55555555);
+    const __m128i mask2 = _mm_set1_epi32(0x33333333);
+    const __m128i mask4 = _mm_set1_epi32(0x0f0f0f0f);
+    const __m128i mask8 = _mm_set1_epi32(0x00ff00ff);
+    const __m128i mask16 = _mm_set1_epi32(0x0000ffff);
+
+#define JH_OPT_SBOX_L(r)                                                                           \
+    jh_sbox(x0, x2, x4, x6, _mm_loadu_si128(cc + 2 * (r)));                                        \
+    jh_sbox(x1, x3, x5, x7, _mm_loadu_si128(cc + 2 * (r) + 1));                                    \
+    jh_l(x0, x2, x4, x6, x1, x3, x5, x7);
+
+#define JH_OPT_SWAP(mask, n)                                                                       \
+    x1 = jh_swap(x1, mask, n), x3 = jh_swap(x3, mask, n);                                          \
+    x5 = jh_swap(x5, mask, n), x7 = jh_swap(x7, mask, n);
+
+#define JH_OPT_SHUFFLE(s)                                                                          \
+    x1 = _mm_shuffle_epi32(x1, s), x3 = _mm_shuffle_epi32(x3, s);                                  \
+    x5 = _mm_shuffle_epi32(x5, s), x7 = _mm_shuffle_epi32(x7, s);
+
+    const __m128i *cc = reinterpret_cast<const __m128i *>(JH_E8_bitslice_roundconstant);
+    unsigned int r = 0;
+
+    /* the full groups of seven rounds run straight, the swapping layer is given by r % 7 */
+    for (; r + 7 <= jhNumRounds; r += 7) {
+        JH_OPT_SBOX_L(r)
+        JH_OPT_SWAP(mask1, 1)
+        JH_OPT_SBOX_L(r + 1)
+        JH_OPT_SWAP(mask2, 2)
+        JH_OPT_SBOX_L(r + 2)
+        JH_OPT_SWAP(mask4, 4)
+        JH_OPT_SBOX_L(r + 3)
+        JH_OPT_SWAP(mask8, 8)
+        JH_OPT_SBOX_L(r + 4)
+        JH_OPT_SWAP(mask16, 16)
+        JH_OPT_SBOX_L(r + 5)
+        JH_OPT_SHUFFLE(_MM_SHUFFLE(2, 3, 0, 1))
+        JH_OPT_SBOX_L(r + 6)
+        JH_OPT_SHUFFLE(_MM_SHUFFLE(1, 0, 3, 2))
+    }
+    for (; r < jhNumRounds; ++r) {
+        JH_OPT_SBOX_L(r)
+        switch (r % 7) {
+        case 0: JH_OPT_SWAP(mask1, 1) break;
+        case 1: JH_OPT_SWAP(mask2, 2) break;
+        case 2: JH_OPT_SWAP(mask4, 4) break;
+        case 3: JH_OPT_SWAP(mask8, 8) break;
+        case 4: JH_OPT_SWAP(mask16, 16) break;
+        default: JH_OPT_SHUFFLE(_MM_SHUFFLE(2, 3, 0, 1)) break;
+        }
+    }
+
+    _mm_storeu_si128(state + 0, x0), _mm_storeu_si128(state + 1, x1);
+    _mm_storeu_si128(state + 2, x2), _mm_storeu_si128(state + 3, x3);
+    _mm_storeu_si128(state + 4, x4), _mm_storeu_si128(state + 5, x5);
+    _mm_storeu_si128(state + 6, x6), _mm_storeu_si128(state + 7, x7);
+}
+
+#else
+
+void JH_opt::E8() {
+    JH::E8();
+}
+
+#endif
+
+} // namespace sha3
@@ -0,0 +1,24 @@
+#ifndef JH_OPT_H
+#define JH_OPT_H
+
+#include "JH_sha3.h"
+
+namespace sha3 {
+
+/*
+ * JH with E8 on SSE2 registers: a row x[i][0..3] of the bitsliced state is one vector, so
+ * an Sbox, the linear transform and the swapping layers process a whole row at once and the
+ * last two swapping layers are word shuffles. Without SSE2 the reference E8 is used.
+ */
+class JH_opt : public JH {
+public:
+    JH_opt(const int numRounds)
+        : JH(numRounds) {}
+
+protected:
+    void E8() override;
+};
+
+} // namespace sha3
+
+#endif
@@ -224,7 +224,7 @@ void JH::F8() {
     for (i = 0; i < 16; i++) jhState.x[i >> 2][i & 3] ^= ((jh_uint32*) jhState.buffer)[i];
 
     /*perform 42 rounds*/
-    JH::E8();
+    E8();
 
     /*xor the 512-bit message with the second half of the 1024-bit hash state*/
     for (i = 0; i < 16; i++) jhState.x[(i + 16) >> 2][i & 3] ^= ((jh_uint32*) jhState.buffer)[i];
@@ -306,6 +306,42 @@ int JH::Update(const BitSequence* data, DataLength databitlen) {
     return (SUCCESS);
 }
 
+/*whole bytes only, so the buffer always holds an integral number of bytes*/
+int JH::update_bytes(const BitSequence* data, DataLength databytelen) {
+    DataLength index = 0;
+    DataLength buffered = jhState.datasize_in_buffer >> 3;
+
+    jhState.databitlen += databytelen << 3;
+
+    /*fill the remaining data in the buffer to a full message block first*/
+    if (buffered > 0) {
+        if (buffered + databytelen < 64) {
+            memcpy(jhState.buffer + buffered, data, databytelen);
+            jhState.datasize_in_buffer += databytelen << 3;
+            return (SUCCESS);
+        }
+        index = 64 - buffered;
+        memcpy(jhState.buffer + buffered, data, index);
+        databytelen -= index;
+        JH::F8();
+        jhState.datasize_in_buffer = 0;
+    }
+
+    /*hash the remaining full message blocks*/
+    for (; databytelen >= 64; index = index + 64, databytelen = databytelen - 64) {
+        memcpy(jhState.buffer, data + index, 64);
+        JH::F8();
+    }
+
+    /*store the partial block into buffer*/
+    if (databytelen > 0) {
+        memcpy(jhState.buffer, data + index, databytelen);
+        jhState.datasize_in_buffer = databytelen << 3;
+    }
+
+    return (SUCCESS);
+}
+
 /*pad the message, process the padded block(s), truncate the hash value H to obtain the message digest*/
 int JH::Final(BitSequence* hashval) {
     unsigned int i;
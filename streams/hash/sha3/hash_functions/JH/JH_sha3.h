@@ -6,7 +6,11 @@
 
 namespace sha3 {
 
+/*42 round constants, each round constant is 32-byte (256-bit)*/
+extern const unsigned char JH_E8_bitslice_roundconstant[42][32];
+
 class JH : public sha3_interface {
+protected:
 
 #define JH_DEFAULT_NUM_ROUNDS	42
 
@@ -36,7 +40,7 @@ typedef struct {
 	unsigned char buffer[64];         /*the 512-bit message block to be hashed;*/
 } hashState;
 
-private:
+protected:
 unsigned int jhNumRounds;
 hashState jhState;
 
@@ -45,11 +49,14 @@ public:
 JH(const int numRounds);
 int Init(int hashbitlen);
 int Update(const BitSequence *data, DataLength databitlen);
+int update_bytes(const BitSequence *data, DataLength databytelen);
+void *context() { return &jhState; }
+size_t context_size() const { return sizeof(jhState); }
 int Final(BitSequence *hashval);
 int Hash(int hashbitlen, const BitSequence *data,DataLength databitlen, BitSequence *hashval);
 
-private:
-void E8();   /*The bijective function E8, in bitslice form */
+protected:
+virtual void E8();   /*The bijective function E8, in bitslice form, optimized variants override it */
 void F8();   /*The compression function F8 */
 
 };
@@ -64,6 +64,11 @@ int Keccak::Update(const BitSequence *data, DataLength databitlen)
     }
 }
 
+int Keccak::update_bytes(const BitSequence *data, DataLength databytelen)
+{
+    return Absorb((spongeState*)&keccakState, data, databytelen * 8, m_rounds);
+}
+
 int Keccak::Final(BitSequence *hashval)
 {
     return Squeeze(&keccakState, hashval, keccakState.fixedOutputLength, m_rounds);
@@ -29,6 +29,9 @@ public:
 Keccak(const int numRounds=KECCAK_FULL_ROUNDS);
 int Init(int hashbitlen);
 int Update(const BitSequence *data, DataLength databitlen);
+int update_bytes(const BitSequence *data, DataLength databytelen);
+void *context() { return &keccakState; }
+size_t context_size() const { return sizeof(keccakState); }
 int Final(BitSequence *hashval);
 int Hash(int hashbitlen, const BitSequence *data, DataLength databitlen, BitSequence *hashval);
 
@@ -38,13 +38,7 @@ int Skein::Update(const BitSequence *data, DataLength databitlen)
     Skein_Assert(skeinState.statebits % 256 == 0 && (skeinState.statebits-256) < 1024,FAIL);
     if ((databitlen & 7) == 0)  /* partial bytes? */
         {
-        switch ((skeinState.statebits >> 8) & 3)
-            {
-            case 2:  return Skein_512_Update(&skeinState.u.ctx_512,data,databitlen >> 3, _num_rounds);
-            case 1:  return Skein_256_Update(&skeinState.u.ctx_256,data,databitlen >> 3, _num_rounds);
-            case 0:  return Skein1024_Update(&skeinState.u.ctx1024,data,databitlen >> 3, _num_rounds);
-            default: return FAIL;
-            }
+        return Skein::update_bytes(data,databitlen >> 3);
         }
     else
         {   /* handle partial final byte */
@@ -73,6 +67,19 @@ int Skein::Update(const BitSequence *data, DataLength databitlen)
         }
     }
 
+/*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
+/* process whole bytes, no partial-byte padding is possible here */
+int Skein::update_bytes(const BitSequence *data, DataLength databytelen)
+    {
+    switch ((skeinState.statebits >> 8) & 3)
+        {
+        case 2:  return Skein_512_Update(&skeinState.u.ctx_512,data,databytelen, _num_rounds);
+        case 1:  return Skein_256_Update(&skeinState.u.ctx_256,data,databytelen, _num_rounds);
+        case 0:  return Skein1024_Update(&skeinState.u.ctx1024,data,databytelen, _num_rounds);
+        default: return FAIL;
+        }
+    }
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 /* finalize hash computation and output the result (hashbitlen bits) */
 int Skein::Final(BitSequence *hashval)
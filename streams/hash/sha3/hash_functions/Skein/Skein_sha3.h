@@ -50,6 +50,9 @@ public:
     /* "incremental" hashing API */
     int Init  (int hashbitlen);
     int Update(const BitSequence *data, DataLength databitlen);
+    int update_bytes(const BitSequence *data, DataLength databytelen);
+    void *context() { return &skeinState; }
+    size_t context_size() const { return sizeof(skeinState); }
     int Final (BitSequence *hashval);
 
     /* "all-in-one" call */
@@ -4,12 +4,14 @@
 #include "Abacus/Abacus_sha3.h"
 #include "Aurora/Aurora_sha3.h"
 #include "BMW/BMW_sha3.h"
+#include "Blake/Blake_opt.h"
 #include "Blake/Blake_sha3.h"
 #include "Blender/Blender_sha3.h"
 #include "Boole/Boole_sha3.h"
 #include "CHI/Chi_sha3.h"
 #include "CRUNCH/Crunch_sha3.h"
 #include "Cheetah/Cheetah_sha3.h"
+#include "CubeHash/CubeHash_opt.h"
 #include "CubeHash/CubeHash_sha3.h"
 #include "DCH/DCH_sha3.h"
 #include "DynamicSHA/DSHA_sha3.h"
@@ -20,8 +22,10 @@
 // #include "EnRUPT/Enrupt_sha3.h"
 #include "ESSENCE/Essence_sha3.h"
 #include "Fugue/Fugue_sha3.h"
+#include "Grostl/Grostl_opt.h"
 #include "Grostl/Grostl_sha3.h"
 #include "Hamsi/Hamsi_sha3.h"
+#include "JH/JH_opt.h"
 #include "JH/JH_sha3.h"
 #include "Keccak/Keccak_sha3.h"
 #include "Khichidi/Khichidi_sha3.h"
@@ -93,6 +93,8 @@ public:
         if (rounds != 1)
             throw std::runtime_error("MICKEY cipher does not operate with rounds.");
     }
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
     /* Mandatory functions */
 
     /*
@@ -77,6 +77,8 @@ class ECRYPT_Rabbit : public estream_interface {
 public:
     ECRYPT_Rabbit(int rounds)
         : estream_interface(rounds) {}
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
     /* Mandatory functions */
 
     /*
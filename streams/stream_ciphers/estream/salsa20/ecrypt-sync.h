@@ -72,6 +72,8 @@ class ECRYPT_Salsa : public estream_interface {
 public:
     ECRYPT_Salsa(int rounds)
         : estream_interface(rounds) {}
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
     /* Mandatory functions */
 
     /*
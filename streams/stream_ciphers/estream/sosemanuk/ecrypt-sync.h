@@ -89,6 +89,8 @@ public:
     /* Mandatory functions */
     ECRYPT_Sosemanuk(int rounds)
         : estream_interface(rounds) {}
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
 
     /*
      * Key and message independent initialization. This function will be
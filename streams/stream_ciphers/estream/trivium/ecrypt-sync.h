@@ -69,6 +69,8 @@ class ECRYPT_Trivium : public estream_interface {
 public:
     ECRYPT_Trivium(int rounds)
         : estream_interface(rounds) {}
+    void *context() override { return &_ctx; }
+    std::size_t context_size() const override { return sizeof(_ctx); }
     /* Mandatory functions */
 
     /*
@@ -1,6 +1,7 @@
 #include "stream_cipher.h"
 #include "stream_interface.h"
 #include <algorithm>
+#include <registry.h>
 #include <streams.h>
 
 #include "estream/abc/ecrypt-sync.h"
@@ -36,45 +37,70 @@
 
 namespace stream_ciphers {
 
-std::unique_ptr<stream_interface> create_stream_cipher(const std::string &name,
-                                                       const unsigned round) {
+template <typename Cipher>
+static std::unique_ptr<stream_interface> with_rounds(const unsigned round) {
+    return std::make_unique<Cipher>(round);
+}
+
+// ciphers with a fixed number of rounds
+template <typename Cipher>
+static std::unique_ptr<stream_interface> without_rounds(const unsigned) {
+    return std::make_unique<Cipher>();
+}
+
+using stream_cipher_constructor = std::unique_ptr<stream_interface> (*)(unsigned);
+
+static const registry<stream_cipher_constructor> &stream_cipher_types() {
     // clang-format off
-    // eSTREAM
-    if (name == "ABC")              return std::make_unique<estream::ECRYPT_ABC>();
-    if (name == "Achterbahn")       return std::make_unique<estream::ECRYPT_Achterbahn>();
-    // if (name == "CryptMT")          return std::make_unique<estream::ECRYPT_Cryptmt>(); // Doesn't work on debian
-    if (name == "DECIM")            return std::make_unique<estream::ECRYPT_Decim>(round);
-    if (name == "DICING")           return std::make_unique<estream::ECRYPT_Dicing>();
-    if (name == "Dragon")           return std::make_unique<estream::ECRYPT_Dragon>(round);
-    if (name == "Edon80")           return std::make_unique<estream::ECRYPT_Edon80>();
-    if (name == "F-FCSR")           return std::make_unique<estream::ECRYPT_FFCSR>(round);
-    if (name == "Fubuki")           return std::make_unique<estream::ECRYPT_Fubuki>(round);
-    if (name == "Grain")            return std::make_unique<estream::ECRYPT_Grain>(round);
-    if (name == "HC-128")           return std::make_unique<estream::ECRYPT_HC128>();
-    if (name == "Hermes")           return std::make_unique<estream::ECRYPT_Hermes>(round);
-    if (name == "LEX")              return std::make_unique<estream::ECRYPT_Lex>(round);
-    if (name == "MAG")              return std::make_unique<estream::ECRYPT_Mag>();
-    if (name == "MICKEY")           return std::make_unique<estream::ECRYPT_Mickey>(round);
-    if (name == "Mir-1")            return std::make_unique<estream::ECRYPT_Mir>();
-    if (name == "Pomaranch")        return std::make_unique<estream::ECRYPT_Pomaranch>();
-    if (name == "Py")               return std::make_unique<estream::ECRYPT_Py>();
-    if (name == "Rabbit")           return std::make_unique<estream::ECRYPT_Rabbit>(round);
-    if (name == "Salsa20")          return std::make_unique<estream::ECRYPT_Salsa>(round);
-    if (name == "SFINKS")           return std::make_unique<estream::ECRYPT_Sfinks>();
-    if (name == "SOSEMANUK")        return std::make_unique<estream::ECRYPT_Sosemanuk>(round);
-    if (name == "Trivium")          return std::make_unique<estream::ECRYPT_Trivium>(round);
-    if (name == "TSC-4")            return std::make_unique<estream::ECRYPT_Tsc4>(round);
-    if (name == "WG")               return std::make_unique<estream::ECRYPT_Wg>();
-    // if (name == "Yamb")             return std::make_unique<estream::ECRYPT_Yamb>();
-    if (name == "Zk-Crypt")         return std::make_unique<estream::ECRYPT_Zkcrypt>();
-
-    // other
-    if (name == "Chacha")           return std::make_unique<others::Chacha>(round);
-    if (name == "RC4")              return std::make_unique<others::rc4>(round);
+    static const registry<stream_cipher_constructor> ciphers = {
+        // eSTREAM
+        {"ABC",              without_rounds<estream::ECRYPT_ABC>},
+        {"Achterbahn",       without_rounds<estream::ECRYPT_Achterbahn>},
+        // {"CryptMT",          without_rounds<estream::ECRYPT_Cryptmt>}, // Doesn't work on debian
+        {"DECIM",            with_rounds<estream::ECRYPT_Decim>},
+        {"DICING",           without_rounds<estream::ECRYPT_Dicing>},
+        {"Dragon",           with_rounds<estream::ECRYPT_Dragon>},
+        {"Edon80",           without_rounds<estream::ECRYPT_Edon80>},
+        {"F-FCSR",           with_rounds<estream::ECRYPT_FFCSR>},
+        {"Fubuki",           with_rounds<estream::ECRYPT_Fubuki>},
+        {"Grain",            with_rounds<estream::ECRYPT_Grain>},
+        {"HC-128",           without_rounds<estream::ECRYPT_HC128>},
+        {"Hermes",           with_rounds<estream::ECRYPT_Hermes>},
+        {"LEX",              with_rounds<estream::ECRYPT_Lex>},
+        {"MAG",              without_rounds<estream::ECRYPT_Mag>},
+        {"MICKEY",           with_rounds<estream::ECRYPT_Mickey>},
+        {"Mir-1",            without_rounds<estream::ECRYPT_Mir>},
+        {"Pomaranch",        without_rounds<estream::ECRYPT_Pomaranch>},
+        {"Py",               without_rounds<estream::ECRYPT_Py>},
+        {"Rabbit",           with_rounds<estream::ECRYPT_Rabbit>},
+        {"Salsa20",          with_rounds<estream::ECRYPT_Salsa>},
+        {"SFINKS",           without_rounds<estream::ECRYPT_Sfinks>},
+        {"SOSEMANUK",        with_rounds<estream::ECRYPT_Sosemanuk>},
+        {"Trivium",          with_rounds<estream::ECRYPT_Trivium>},
+        {"TSC-4",            with_rounds<estream::ECRYPT_Tsc4>},
+        {"WG",               without_rounds<estream::ECRYPT_Wg>},
+        // {"Yamb",             without_rounds<estream::ECRYPT_Yamb>},
+        {"Zk-Crypt",         without_rounds<estream::ECRYPT_Zkcrypt>},
+
+        // other
+        {"Chacha",           with_rounds<others::Chacha>},
+        {"RC4",              with_rounds<others::rc4>},
+    };
     // clang-format on
+    return ciphers;
+}
 
-    throw std::runtime_error("requested eSTREAM cipher named \"" + name +
-                             "\" is either broken or does not exists");
+std::vector<std::string> stream_cipher_names() {
+    return stream_cipher_types().names();
+}
+
+std::unique_ptr<stream_interface> create_stream_cipher(const std::string &name,
+                                                       const unsigned round) {
+    const stream_cipher_constructor *constructor = stream_cipher_types().find(name);
+    if (constructor == nullptr)
+        throw std::runtime_error("requested eSTREAM cipher named \"" + name +
+                                 "\" is either broken or does not exists");
+    return (*constructor)(round);
 }
 
 stream_cipher::stream_cipher(const std::string &name,
@@ -116,4 +142,27 @@ void stream_cipher::decrypt(const u8 *ciphertext, u8 *plaintext, std::size_t siz
     _decryptor->decrypt_bytes(ciphertext, plaintext, u32(size));
 }
 
+void stream_cipher::save_state(std::ostream &out) const {
+    stream_state::write(out, _iv);
+    stream_state::write(out, _key);
+    for (auto *cipher : {_encryptor.get(), _decryptor.get()}) {
+        if (cipher->context_size() == 0)
+            throw std::runtime_error("stream cipher cannot save its state");
+        const auto *context = static_cast<const char *>(cipher->context());
+        stream_state::write(out, std::vector<char>(context, context + cipher->context_size()));
+    }
+}
+
+void stream_cipher::load_state(std::istream &in) {
+    stream_state::read(in, _iv);
+    stream_state::read(in, _key);
+    for (auto *cipher : {_encryptor.get(), _decryptor.get()}) {
+        std::vector<char> context;
+        stream_state::read(in, context);
+        if (cipher->context_size() == 0 || context.size() != cipher->context_size())
+            throw std::runtime_error("stream cipher cannot load its state");
+        std::copy(context.begin(), context.end(), static_cast<char *>(cipher->context()));
+    }
+}
+
 } // namespace stream_ciphers
@@ -6,6 +6,7 @@
 #include <eacirc-core/random.h>
 #include <memory>
 #include <stream.h>
+#include <vector>
 
 #include "stream_interface.h"
 
@@ -14,6 +15,9 @@ namespace stream_ciphers {
 std::unique_ptr<stream_interface> create_stream_cipher(const std::string &name,
                                                        const unsigned round);
 
+/** Names of all the ciphers create_stream_cipher knows */
+std::vector<std::string> stream_cipher_names();
+
 struct stream_cipher {
     stream_cipher(const std::string &name,
                   const unsigned round,
@@ -28,6 +32,12 @@ struct stream_cipher {
     void encrypt(const std::uint8_t *plaintext, std::uint8_t *ciphertext, const std::size_t size);
     void decrypt(const std::uint8_t *ciphertext, std::uint8_t *plaintext, const std::size_t size);
 
+    /**
+     * Key, IV and the position in the keystream, throws unless the cipher exposes its context
+     */
+    void save_state(std::ostream &out) const;
+    void load_state(std::istream &in);
+
 protected:
     std::vector<value_type> _iv;
     std::vector<value_type> _key;
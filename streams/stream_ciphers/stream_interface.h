@@ -1,6 +1,7 @@
 #pragma once
 
 #include "estream/ecrypt-portable.h"
+#include <cstddef>
 
 namespace stream_ciphers {
 
@@ -21,6 +22,14 @@ struct stream_interface {
     virtual void encrypt_bytes(const u8 *plaintext, u8 *ciphertext, const u32 msglen) = 0;
     virtual void decrypt_bytes(const u8 *ciphertext, u8 *plaintext, const u32 msglen) = 0;
 
+    /**
+     * Raw memory of the cipher context. Ciphers whose context is self-contained (no pointers,
+     * no state kept elsewhere) expose it, so the position in the keystream can be saved to a
+     * checkpoint and restored. The default opts out.
+     */
+    virtual void *context() { return nullptr; }
+    virtual std::size_t context_size() const { return 0; }
+
 protected:
     const int _rounds;
 };
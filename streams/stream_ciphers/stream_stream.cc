@@ -47,4 +47,21 @@ vec_cview stream_stream::next() {
     return make_cview(_data);
 }
 
+void stream_stream::save_state(std::ostream &out) const {
+    _iv_stream->save_state(out);
+    _key_stream->save_state(out);
+    _source->save_state(out);
+    // a cipher set up for every vector starts afresh, the streams are all of its state
+    if (!_reinit)
+        _algorithm.save_state(out);
+}
+
+void stream_stream::load_state(std::istream &in) {
+    _iv_stream->load_state(in);
+    _key_stream->load_state(in);
+    _source->load_state(in);
+    if (!_reinit)
+        _algorithm.load_state(in);
+}
+
 } // namespace stream_ciphers
@@ -15,6 +15,9 @@ struct stream_stream : stream {
 
     vec_cview next() override;
 
+    void save_state(std::ostream &out) const override;
+    void load_state(std::istream &in) override;
+
 private:
 
     const bool _reinit;
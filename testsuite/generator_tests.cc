@@ -0,0 +1,371 @@
+#include "generator.h"
+#include "output_cache.h"
+#include "stream.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::vector<std::uint8_t> read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+// a new file, the old one may be linked to an entry of the cache
+static void write_file(const std::string &path, const std::vector<std::uint8_t> &bytes) {
+    std::remove(path.c_str());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+}
+
+static unsigned links(const std::string &path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 ? unsigned(info.st_nlink) : 0;
+}
+
+// the cache directory and its entries
+static void remove_cache(const std::string &directory) {
+    if (DIR *entries = ::opendir(directory.c_str())) {
+        while (const dirent *entry = ::readdir(entries))
+            std::remove((directory + "/" + entry->d_name).c_str());
+        ::closedir(entries);
+    }
+    ::rmdir(directory.c_str());
+}
+
+// a seeded stream without files, its outputs are cached
+static json cached_config(const std::uint64_t tv_count, const std::string &file_name) {
+    return {{"seed", "1fe40505e131963c"},
+            {"tv_size", 16},
+            {"tv_count", tv_count},
+            {"file_name", file_name},
+            {"cache", "generator_test_cache"},
+            {"stream", {{"type", "xor_stream"}, {"source", {{"type", "pcg32_stream"}}}}}};
+}
+
+// the bytes of the config generated without the cache
+static std::vector<std::uint8_t> uncached_output(json config) {
+    config.erase("cache");
+    config["file_name"] = "generator_test_reference.bin";
+    generator(config).generate();
+    const auto bytes = read_file("generator_test_reference.bin");
+    std::remove("generator_test_reference.bin");
+    return bytes;
+}
+
+// every output of the sweep is the output of a run of its variant alone
+static void expect_variants_as_alone(const json &sweep) {
+    generator(sweep).generate();
+
+    std::vector<json> variants = {sweep};
+    variants.front().erase("sweep");
+    for (auto parameter = sweep.at("sweep").begin(); parameter != sweep.at("sweep").end();
+         ++parameter) {
+        std::vector<json> expanded;
+        for (const json &variant : variants)
+            for (const json &value : *parameter) {
+                expanded.push_back(variant);
+                expanded.back()["stream"][parameter.key()] = value;
+            }
+        variants = std::move(expanded);
+    }
+
+    for (json variant : variants) {
+        std::string swept = sweep.at("file_name");
+        for (auto parameter = sweep.at("sweep").begin(); parameter != sweep.at("sweep").end();
+             ++parameter) {
+            const std::string placeholder = "{" + parameter.key() + "}";
+            swept.replace(swept.find(placeholder),
+                          placeholder.size(),
+                          variant.at("stream").at(parameter.key()).dump());
+        }
+        variant["file_name"] = "generator_test_alone.bin";
+        generator(variant).generate();
+        EXPECT_EQ(read_file("generator_test_alone.bin"), read_file(swept)) << swept;
+        EXPECT_EQ(std::uint64_t(variant.at("tv_count")) * std::uint64_t(variant.at("tv_size")),
+                  read_file(swept).size())
+            << swept;
+        std::remove("generator_test_alone.bin");
+        std::remove(swept.c_str());
+    }
+}
+
+TEST(generator, sweep_of_rounds_is_the_same_as_runs_alone) {
+    // the key and the plaintext have the same config, they are not one stream
+    expect_variants_as_alone(R"({
+        "seed": "1fe40505e131963c",
+        "tv_size": 16,
+        "tv_count": 3000,
+        "file_name": "generator_test_sweep_{round}.bin",
+        "sweep": {"round": [1, 10]},
+        "stream": {
+            "type": "block",
+            "init_frequency": "only_once",
+            "algorithm": "AES",
+            "round": 1,
+            "block_size": 16,
+            "plaintext": {"type": "pcg32_stream"},
+            "key_size": 16,
+            "key": {"type": "pcg32_stream"},
+            "iv": {"type": "false_stream"}
+        }
+    })"_json);
+}
+
+TEST(generator, sweep_of_block_sizes_is_the_same_as_runs_alone) {
+    // the plaintexts of other sizes are not shared, the key after them is
+    expect_variants_as_alone(R"({
+        "seed": "1fe40505e131963c",
+        "tv_size": 64,
+        "tv_count": 3000,
+        "file_name": "generator_test_sweep_{round}_{block_size}.bin",
+        "sweep": {"round": [1, 12], "block_size": [16, 64]},
+        "stream": {
+            "type": "estream",
+            "algorithm": "Salsa20",
+            "round": 12,
+            "block_size": 16,
+            "plaintext": {"type": "pcg32_stream"},
+            "key_size": 16,
+            "key": {"type": "pcg32_stream"},
+            "iv": {"type": "false_stream"}
+        }
+    })"_json);
+}
+
+TEST(output_cache, restores_whole_outputs_and_prefixes) {
+    remove_cache("generator_test_cache");
+    output_cache cache("generator_test_cache");
+    std::vector<std::uint8_t> bytes(1000);
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+        bytes[i] = std::uint8_t(i * 7);
+    write_file("generator_test_output.bin", bytes);
+    cache.store("key", "generator_test_output.bin", "state");
+    EXPECT_EQ("state", cache.state("key"));
+
+    // the whole output is the entry itself
+    EXPECT_EQ(1000, cache.restore("key", "generator_test_restored.bin", 1000));
+    EXPECT_EQ(bytes, read_file("generator_test_restored.bin"));
+    EXPECT_LT(1u, links("generator_test_restored.bin"));
+
+    // a prefix is a file of its own, cutting it does not touch the entry
+    EXPECT_EQ(300, cache.restore("key", "generator_test_restored.bin", 300));
+    EXPECT_EQ(std::vector<std::uint8_t>(bytes.begin(), bytes.begin() + 300),
+              read_file("generator_test_restored.bin"));
+    EXPECT_EQ(1u, links("generator_test_restored.bin"));
+
+    // a longer output gets what there is, the generator extends it
+    EXPECT_EQ(1000, cache.restore("key", "generator_test_restored.bin", 5000));
+    EXPECT_EQ(bytes, read_file("generator_test_restored.bin"));
+    EXPECT_EQ(1u, links("generator_test_restored.bin"));
+
+    std::remove("generator_test_output.bin");
+    std::remove("generator_test_restored.bin");
+    remove_cache("generator_test_cache");
+}
+
+TEST(output_cache, stale_entries_are_not_used) {
+    remove_cache("generator_test_cache");
+    output_cache cache("generator_test_cache");
+    write_file("generator_test_output.bin", std::vector<std::uint8_t>(100, 1));
+    cache.store("key", "generator_test_output.bin", "state of 100 bytes");
+
+    // another key gives nothing, the old output at the path is removed anyway
+    write_file("generator_test_restored.bin", std::vector<std::uint8_t>(10, 2));
+    EXPECT_EQ(0, cache.restore("other key", "generator_test_restored.bin", 100));
+    EXPECT_EQ(0u, links("generator_test_restored.bin"));
+    EXPECT_EQ("", cache.state("other key"));
+
+    // a shorter output does not replace the entry
+    write_file("generator_test_output.bin", std::vector<std::uint8_t>(50, 3));
+    cache.store("key", "generator_test_output.bin", "state of 50 bytes");
+    EXPECT_EQ(100, cache.restore("key", "generator_test_restored.bin", 1000));
+    EXPECT_EQ("state of 100 bytes", cache.state("key"));
+
+    // a longer one without a state removes the state of the old one
+    write_file("generator_test_output.bin", std::vector<std::uint8_t>(200, 4));
+    cache.store("key", "generator_test_output.bin", "");
+    EXPECT_EQ(200, cache.restore("key", "generator_test_restored.bin", 1000));
+    EXPECT_EQ(std::vector<std::uint8_t>(200, 4), read_file("generator_test_restored.bin"));
+    EXPECT_EQ("", cache.state("key"));
+
+    std::remove("generator_test_output.bin");
+    std::remove("generator_test_restored.bin");
+    remove_cache("generator_test_cache");
+}
+
+TEST(output_cache, output_linked_to_an_entry_is_not_rewritten) {
+    remove_cache("generator_test_cache");
+    const json config = cached_config(100, "generator_test_output.bin");
+    const auto expected = uncached_output(config);
+
+    generator(config).generate();
+    // taken from the cache as a whole, the output is a link to the entry
+    generator(config).generate();
+    ASSERT_LT(1u, links("generator_test_output.bin"));
+
+    // another run writing the same file without the cache
+    json other = config;
+    other.erase("cache");
+    other["seed"] = "0000000000000001";
+    other["tv_count"] = 10;
+    generator(other).generate();
+    EXPECT_EQ(160u, read_file("generator_test_output.bin").size());
+
+    generator(config).generate();
+    EXPECT_EQ(expected, read_file("generator_test_output.bin"));
+
+    std::remove("generator_test_output.bin");
+    remove_cache("generator_test_cache");
+}
+
+TEST(output_cache, extended_output_is_the_same_as_uncached) {
+    remove_cache("generator_test_cache");
+    generator(cached_config(40, "generator_test_short.bin")).generate();
+
+    // the cached 40 vectors are extended from the state of the streams stored with them
+    const json longer = cached_config(100, "generator_test_output.bin");
+    generator(longer).generate();
+    EXPECT_EQ(uncached_output(longer), read_file("generator_test_output.bin"));
+
+    // and the longer output is cached in turn
+    const json shorter = cached_config(70, "generator_test_restored.bin");
+    generator(shorter).generate();
+    EXPECT_EQ(uncached_output(shorter), read_file("generator_test_restored.bin"));
+
+    std::remove("generator_test_short.bin");
+    std::remove("generator_test_output.bin");
+    std::remove("generator_test_restored.bin");
+    remove_cache("generator_test_cache");
+}
+
+TEST(output_cache, sweep_gives_the_outputs_of_runs_alone) {
+    remove_cache("generator_test_cache");
+    json sweep = R"({
+        "seed": "1fe40505e131963c",
+        "tv_size": 16,
+        "tv_count": 100,
+        "file_name": "generator_test_sweep_{round}.bin",
+        "cache": "generator_test_cache",
+        "sweep": {"round": [1, 10]},
+        "stream": {
+            "type": "block",
+            "init_frequency": "only_once",
+            "algorithm": "AES",
+            "round": 1,
+            "block_size": 16,
+            "plaintext": {"type": "pcg32_stream"},
+            "key_size": 16,
+            "key": {"type": "pcg32_stream"},
+            "iv": {"type": "false_stream"}
+        }
+    })"_json;
+    generator(sweep).generate();
+
+    // a run of a variant alone takes the output of the sweep from the cache
+    json alone = sweep;
+    alone.erase("sweep");
+    alone["stream"]["round"] = 10;
+    alone["file_name"] = "generator_test_output.bin";
+    generator(alone).generate();
+    EXPECT_LT(1u, links("generator_test_output.bin"));
+    EXPECT_EQ(uncached_output(alone), read_file("generator_test_output.bin"));
+
+    // and extends it, the state of the streams of the sweep is not the state of a run alone
+    alone["tv_count"] = 300;
+    generator(alone).generate();
+    EXPECT_EQ(uncached_output(alone), read_file("generator_test_output.bin"));
+
+    std::remove("generator_test_sweep_1.bin");
+    std::remove("generator_test_sweep_10.bin");
+    std::remove("generator_test_output.bin");
+    remove_cache("generator_test_cache");
+}
+
+// vectors and whether the state of the streams is saved in the checkpoint of the output
+static std::pair<std::uint64_t, bool> read_checkpoint(const std::string &output) {
+    std::ifstream file(output + ".checkpoint", std::ios::binary);
+    std::string magic;
+    std::getline(file, magic);
+    EXPECT_EQ("crypto-streams checkpoint 1", magic);
+    std::string key, run;
+    std::uint64_t count = 0;
+    bool has_state = false;
+    stream_state::read(file, key);
+    stream_state::read(file, run);
+    stream_state::read(file, count);
+    stream_state::read(file, has_state);
+    return {count, has_state};
+}
+
+static void append_file(const std::string &path, const std::vector<std::uint8_t> &bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write(reinterpret_cast<const char *>(bytes.data()), std::streamsize(bytes.size()));
+}
+
+// a run killed after a checkpoint is resumed, the output is the same as of a run not stopped
+static void expect_resumed_byte_exactly(json config, const bool has_state) {
+    config["file_name"] = "generator_test_output.bin";
+    config["checkpoint"] = 100;
+    config["tv_count"] = 1000;
+    json uninterrupted = config;
+    uninterrupted.erase("checkpoint");
+    const auto expected = uncached_output(uninterrupted);
+
+    // the run is stopped after a checkpoint, it wrote some vectors after it
+    json stopped = config;
+    stopped["tv_count"] = 300;
+    generator(stopped).generate();
+    EXPECT_EQ(std::make_pair(std::uint64_t(300), has_state),
+              read_checkpoint("generator_test_output.bin"));
+    append_file("generator_test_output.bin", std::vector<std::uint8_t>(40, 0xff));
+
+    // the output is cut back to the checkpoint and continued
+    generator(config).generate();
+    EXPECT_EQ(expected, read_file("generator_test_output.bin"));
+    EXPECT_EQ(std::make_pair(std::uint64_t(1000), has_state),
+              read_checkpoint("generator_test_output.bin"));
+
+    // an output shorter than its checkpoint is not resumed, it is generated anew
+    write_file("generator_test_output.bin",
+               std::vector<std::uint8_t>(expected.begin(), expected.begin() + 50 * 16));
+    generator(config).generate();
+    EXPECT_EQ(expected, read_file("generator_test_output.bin"));
+
+    // nor is a checkpoint of another config
+    json other = config;
+    other["seed"] = "0000000000000001";
+    generator(other).generate();
+    generator(config).generate();
+    EXPECT_EQ(expected, read_file("generator_test_output.bin"));
+
+    std::remove("generator_test_output.bin");
+    std::remove("generator_test_output.bin.checkpoint");
+}
+
+TEST(generator, resumed_from_saved_state) {
+    expect_resumed_byte_exactly(
+        {{"seed", "1fe40505e131963c"},
+         {"tv_size", 16},
+         {"stream", {{"type", "xor_stream"}, {"source", {{"type", "pcg32_stream"}}}}}},
+        true);
+}
+
+TEST(generator, resumed_by_replay_without_state) {
+    // an async stage cannot save its state, the resumed run computes the kept vectors again
+    expect_resumed_byte_exactly({{"seed", "1fe40505e131963c"},
+                                 {"tv_size", 16},
+                                 {"stream",
+                                  {{"type", "xor_stream"},
+                                   {"async", true},
+                                   {"source", {{"type", "pcg32_stream"}}}}}},
+                                false);
+}
+#endif
@@ -122,6 +122,82 @@ TEST(md5, test_vectors) {
     testsuite::hash_test_case("MD5", 64)();
 }
 
+TEST(hash_messages, lanes_match_single_messages) {
+    const std::vector<std::pair<std::string, std::size_t>> functions = {
+        {"SHA1", 20}, {"SHA2", 32}, {"MD5", 16}};
+    // count is not a multiple of lanes, so the tail is hashed one by one as well
+    const std::size_t count = 19;
+
+    for (const auto &function : functions) {
+        const std::size_t digest = function.second;
+
+        for (const unsigned rounds : {0u, 1u, 17u, 64u, 80u}) {
+            auto hasher = hash::hash_factory::create(function.first, rounds);
+
+            for (const std::size_t length : {0u, 1u, 55u, 56u, 64u, 119u, 200u}) {
+                std::vector<std::uint8_t> data(count * length);
+                for (std::size_t i = 0; i < data.size(); ++i)
+                    data[i] = std::uint8_t(i * 131 + length);
+
+                std::vector<std::uint8_t> expected(count * digest);
+                for (std::size_t i = 0; i < count; ++i) {
+                    hasher->Init(int(digest * 8));
+                    hasher->update_bytes(data.data() + i * length, length);
+                    hasher->Final(expected.data() + i * digest);
+                }
+
+                std::vector<std::uint8_t> hashes(count * digest);
+                ASSERT_EQ(0, hasher->hash_messages(
+                                 int(digest * 8), data.data(), length, count, hashes.data()));
+                ASSERT_EQ(expected, hashes) << function.first << " rounds " << rounds
+                                            << " length " << length;
+            }
+        }
+    }
+}
+
+TEST(hash_factory, optimized_match_reference) {
+    const std::vector<std::string> functions = {"BLAKE", "CubeHash", "Grostl", "JH"};
+
+    for (const auto &function : functions) {
+        for (const unsigned rounds : {0u, 1u, 3u, 7u, 8u, 10u, 13u, 14u, 16u, 42u, 72u}) {
+            auto optimized = hash::hash_factory::create(function, rounds);
+            auto reference =
+                hash::hash_factory::create(function, rounds, hash::hash_implementation::reference);
+
+            for (const int digest : {224, 256, 384, 512}) {
+                // the reference short Grostl is undefined below its full rounds
+                if (function == "Grostl" && digest <= 256 && rounds < 10)
+                    continue;
+                // the reference BLAKE has the permutations of its first 20 rounds only
+                if (function == "BLAKE" && rounds > 20)
+                    continue;
+                // the reference JH has the constants of its full 42 rounds only
+                if (function == "JH" && rounds > 42)
+                    continue;
+
+                for (const std::size_t length : {0u, 1u, 31u, 64u, 65u, 129u, 300u}) {
+                    std::vector<std::uint8_t> data(length);
+                    for (std::size_t i = 0; i < length; ++i)
+                        data[i] = std::uint8_t(i * 167 + rounds);
+
+                    std::vector<std::uint8_t> expected(std::size_t(digest / 8));
+                    std::vector<std::uint8_t> hash(std::size_t(digest / 8));
+                    ASSERT_EQ(0, reference->Init(digest));
+                    ASSERT_EQ(0, reference->update_bytes(data.data(), length));
+                    ASSERT_EQ(0, reference->Final(expected.data()));
+                    ASSERT_EQ(0, optimized->Init(digest));
+                    ASSERT_EQ(0, optimized->update_bytes(data.data(), length));
+                    ASSERT_EQ(0, optimized->Final(hash.data()));
+
+                    ASSERT_EQ(expected, hash) << function << " rounds " << rounds << " digest "
+                                              << digest << " length " << length;
+                }
+            }
+        }
+    }
+}
+
 TEST(gost, test_vectors) {
     testsuite::hash_test_case("Gost", 32)();
 }
@@ -137,3 +213,103 @@ TEST(tiger, test_vectors) {
 TEST(whirlpool, test_vectors) {
     testsuite::hash_test_case("Whirlpool", 10)();
 }
+
+TEST(iterated_hash, same_as_nested_hash_streams) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+
+    for (const std::string algorithm : {"SHA2", "Skein", "MD5"}) {
+        const std::size_t hash_size = algorithm == "MD5" ? 16 : 32;
+        const std::size_t rounds = algorithm == "Skein" ? 72 : 64;
+
+        // not fused into an iterated hash, so the levels are hashed one by one
+        json nested = {{"type", "counter"}};
+        for (int i = 0; i < 3; ++i)
+            nested = {{"type", "hash"},
+                      {"algorithm", algorithm},
+                      {"round", rounds},
+                      {"hash_size", hash_size},
+                      {"fuse", false},
+                      {"source", nested}};
+        const json iterated = {{"type", "iterated_hash"},
+                               {"algorithm", algorithm},
+                               {"round", rounds},
+                               {"hash_size", hash_size},
+                               {"iterations", 3},
+                               {"source", {{"type", "counter"}}}};
+
+        auto reference = make_stream(nested, seeder, map, 10 * hash_size);
+        auto tested = make_stream(iterated, seeder, map, 10 * hash_size);
+        for (int i = 0; i < 4; ++i)
+            ASSERT_EQ(reference->next().copy_to_vector(), tested->next().copy_to_vector())
+                << algorithm;
+    }
+}
+
+TEST(iterated_hash, compiled_from_nested_hash_streams) {
+    const json counter = {{"type", "counter"}};
+    const json inner = {{"type", "hash"},
+                        {"algorithm", "SHA2"},
+                        {"round", 64},
+                        {"hash_size", 32},
+                        {"input_size", 16},
+                        {"source", counter}};
+    json nested = {{"type", "sha3"},
+                   {"algorithm", "SHA2"},
+                   {"round", 64},
+                   {"hash_size", 32},
+                   {"source", {{"type", "iterated_hash"},
+                               {"algorithm", "SHA2"},
+                               {"round", 64},
+                               {"hash_size", 32},
+                               {"iterations", 2},
+                               {"source", inner}}}};
+
+    // the hashes of the counter are a single kernel
+    const json compiled = compile_stream(nested, 32);
+    EXPECT_EQ("counter_hash", compiled.at("type"));
+    EXPECT_EQ(4, compiled.at("iterations"));
+    EXPECT_EQ(16, compiled.at("input_size"));
+    EXPECT_EQ(counter, compiled.at("source"));
+
+    // a different number of rounds is a different function
+    nested["round"] = 63;
+    EXPECT_EQ(nested, compile_stream(nested, 32));
+}
+
+TEST(counter_hash, same_as_hash_of_counter_stream) {
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    // graphs of their own, identical ones in one graph would be shared
+    const auto build = [&seeder](const json &config, const std::size_t osize) {
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+        return make_stream(config, seeder, map, osize);
+    };
+    const json counter = {{"type", "counter"}, {"endianness", "big"}, {"step", 3}};
+
+    // SHA2 hashes the batch on several lanes, MD5 one message at a time
+    for (const std::string algorithm : {"SHA2", "MD5"})
+        for (const std::size_t iterations : {1, 2}) {
+            const std::size_t hash_size = algorithm == "MD5" ? 16 : 32;
+            json hash = {{"type", "iterated_hash"},
+                         {"algorithm", algorithm},
+                         {"round", 64},
+                         {"hash_size", hash_size},
+                         {"input_size", 20},
+                         {"iterations", iterations},
+                         {"source", counter}};
+            ASSERT_EQ("counter_hash", compile_stream(hash, 4 * hash_size).at("type"));
+
+            auto fused = build(hash, 4 * hash_size);
+            hash["fuse"] = false;
+            auto interpreted = build(hash, 4 * hash_size);
+            for (int i = 0; i < 5; ++i)
+                ASSERT_EQ(interpreted->next().copy_to_vector(), fused->next().copy_to_vector())
+                    << algorithm << " " << iterations << " " << i;
+
+            std::stringstream state;
+            fused->save_state(state);
+            auto loaded = build(hash, 4 * hash_size);
+            loaded->load_state(state);
+            EXPECT_EQ(fused->next().copy_to_vector(), loaded->next().copy_to_vector());
+        }
+}
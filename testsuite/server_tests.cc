@@ -0,0 +1,107 @@
+#include "generator.h"
+#include "server.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const json served_config = R"({
+     "seed": "1fe40505e131963c",
+     "tv_size": 16,
+     "tv_count": 300,
+     "stream": {
+         "type": "block",
+         "init_frequency": "only_once",
+         "algorithm": "AES",
+         "round": 2,
+         "block_size": 16,
+         "plaintext": {"type": "pcg32_stream"},
+         "key_size": 16,
+         "key": {"type": "pcg32_stream"},
+         "iv": {"type": "false_stream"}
+     }
+ })"_json;
+
+// connection of a consumer, it sends the request and reads up to limit bytes of the answer
+static std::string request(const std::string &path,
+                           const std::string &line,
+                           const std::size_t limit = std::size_t(-1)) {
+    const int connection = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    if (::connect(connection, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(connection);
+        return "cannot connect";
+    }
+
+    const std::string sent = line + "\n";
+    EXPECT_EQ(ssize_t(sent.size()), ::write(connection, sent.data(), sent.size()));
+    std::string answer;
+    char chunk[4096];
+    while (answer.size() < limit) {
+        const std::size_t wanted = std::min(sizeof(chunk), limit - answer.size());
+        const ssize_t received = ::read(connection, chunk, wanted);
+        if (received <= 0)
+            break;
+        answer.append(chunk, std::size_t(received));
+    }
+    ::close(connection);
+    return answer;
+}
+
+TEST(stream_server, serves_the_vectors_of_the_generator) {
+    const std::string path = "server_test_" + std::to_string(::getpid()) + ".sock";
+    stream_server server(path, 1);
+    // a single worker, every connection is served after the one before ended; the checks do not
+    // return before the worker is joined
+    std::thread worker([&server] { server.run(1); });
+
+    struct stat info = {};
+    EXPECT_EQ(0, ::stat(path.c_str(), &info));
+    EXPECT_EQ(0600u, info.st_mode & 0777);
+
+    std::ostringstream expected;
+    generator(served_config).generate(expected);
+    EXPECT_EQ("ok\n" + expected.str(), request(path, served_config.dump()));
+
+    const std::string error = request(path, "{\"seed\": ");
+    EXPECT_EQ("error: ", error.substr(0, 7)) << error;
+
+    // the variants of a sweep are not one stream, the config is rejected before "ok"
+    json sweep = served_config;
+    sweep["sweep"] = {{"round", {1, 2}}};
+    sweep["file_name"] = "server_test_{round}.bin";
+    const std::string rejected = request(path, sweep.dump());
+    EXPECT_EQ("error: ", rejected.substr(0, 7)) << rejected;
+
+    // a consumer which sends nothing holds the only worker until the timeout
+    const int silent = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), address.sun_path);
+    EXPECT_EQ(0, ::connect(silent, reinterpret_cast<const sockaddr *>(&address), sizeof(address)));
+    EXPECT_EQ("ok\n" + expected.str(), request(path, served_config.dump()));
+    char reply[7] = {};
+    EXPECT_EQ(7, ::read(silent, reply, sizeof(reply)));
+    EXPECT_EQ("error: ", std::string(reply, sizeof(reply)));
+    ::close(silent);
+
+    // an endless stream ends when its consumer leaves, the worker serves the next one then
+    json endless = served_config;
+    endless.erase("tv_count");
+    const std::string prefix = request(path, endless.dump(), 3 + 1000 * 16);
+    EXPECT_EQ(("ok\n" + expected.str()).substr(0, 3 + 300 * 16), prefix.substr(0, 3 + 300 * 16));
+    EXPECT_EQ("ok\n" + expected.str(), request(path, served_config.dump()));
+
+    server.stop();
+    worker.join();
+}
+#endif
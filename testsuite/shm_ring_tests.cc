@@ -0,0 +1,143 @@
+#include "generator.h"
+#include "shm_ring.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static std::string ring_name(const std::string &test) {
+    return "/crypto-streams-" + test + "-" + std::to_string(::getpid());
+}
+
+TEST(shm_ring, reader_gets_every_vector_in_order) {
+    const std::string name = ring_name("ring");
+    const std::uint64_t total = 10000;
+    // a capacity the runs of slots do not divide, they end at the end of the ring
+    auto ring = std::make_unique<shm_ring>(name, 24, 7, total);
+    shm_ring_reader reader(name);
+    EXPECT_EQ(24, reader.vector_size());
+
+    std::thread producer([&] {
+        for (std::uint64_t done = 0; done < total;) {
+            const std::uint64_t count = ring->wait_free(total - done);
+            for (std::uint64_t i = 0; i < count; ++i)
+                std::fill_n(ring->slot(done + i), 24, value_type((done + i) % 251));
+            ring->publish(count);
+            done += count;
+        }
+        // closed, the reader ends after the last vector
+        ring.reset();
+    });
+
+    // the reader goes on to the end on a wrong vector, the producer does not block on a full ring
+    std::uint64_t read = 0;
+    std::uint64_t longest = 0;
+    std::uint64_t first_wrong = total;
+    for (std::uint64_t count; (count = reader.wait_available(100)) != 0; read += count) {
+        longest = std::max(longest, count);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            const value_type *vector = reader.vector(read + i);
+            if (first_wrong == total && !std::all_of(vector, vector + 24, [&](value_type byte) {
+                    return byte == value_type((read + i) % 251);
+                }))
+                first_wrong = read + i;
+        }
+        reader.release(count);
+    }
+    producer.join();
+    EXPECT_LE(longest, 7u);
+    EXPECT_EQ(total, first_wrong);
+    EXPECT_EQ(total, read);
+    ::shm_unlink(name.c_str());
+}
+
+TEST(shm_ring, generator_publishes_its_stream) {
+    const std::string name = ring_name("generator");
+    const json config = {{"seed", "1fe40505e131963c"},
+                         {"tv_size", 16},
+                         {"tv_count", 5000},
+                         {"file_name", "shm_ring_test.bin"},
+                         {"shm", name},
+                         {"shm_slots", 7},
+                         {"stream",
+                          {{"type", "xor_stream"}, {"source", {{"type", "pcg32_stream"}}}}}};
+    std::ostringstream expected;
+    generator(config).generate(expected);
+
+    ::shm_unlink(name.c_str());
+    std::string failure;
+    std::thread producer([&config, &failure] {
+        try {
+            generator(config).generate();
+        } catch (std::runtime_error &e) {
+            failure = e.what();
+        }
+    });
+
+    // the ring is there once the producer has created it
+    std::unique_ptr<shm_ring_reader> reader;
+    for (int attempt = 0; !reader && attempt < 10000; ++attempt) {
+        try {
+            reader = std::make_unique<shm_ring_reader>(name);
+        } catch (std::runtime_error &) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::string vectors;
+    if (reader) {
+        EXPECT_EQ(16, reader->vector_size());
+        for (std::uint64_t read = 0, count; (count = reader->wait_available(100)) != 0;
+             read += count) {
+            for (std::uint64_t i = 0; i < count; ++i)
+                vectors.append(reinterpret_cast<const char *>(reader->vector(read + i)), 16);
+            reader->release(count);
+        }
+    }
+    producer.join();
+    EXPECT_EQ("", failure);
+    EXPECT_EQ(expected.str(), vectors);
+    ::shm_unlink(name.c_str());
+}
+
+TEST(shm_ring, slots_outside_the_object_are_rejected) {
+    const std::string name = ring_name("forged");
+    ::shm_unlink(name.c_str());
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(0, ::ftruncate(fd, 8192));
+    void *mapping = ::mmap(nullptr, 8192, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(MAP_FAILED, mapping);
+
+    // a header set up as by a producer, with more slots than the object has room for
+    auto header = new (mapping) shm_ring_header;
+    header->vector_size = 16;
+    header->capacity = 1000;
+    header->total = 1000;
+    header->data_offset = 4096;
+    header->magic.store(shm_ring_magic);
+    EXPECT_THROW(shm_ring_reader reader(name), std::runtime_error);
+
+    // the slots start past the end of the object
+    header->capacity = 1;
+    header->data_offset = 1 << 20;
+    EXPECT_THROW(shm_ring_reader reader(name), std::runtime_error);
+
+    // and fit once they are where they should be
+    header->data_offset = 4096;
+    EXPECT_NO_THROW(shm_ring_reader reader(name));
+
+    ::munmap(mapping, 8192);
+    ::shm_unlink(name.c_str());
+}
+#endif
@@ -3,6 +3,8 @@
 #include <eacirc-core/seed.h>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <sstream>
+#include <streams.h>
 #include <streams/stream_ciphers/stream_cipher.h>
 #include <streams/stream_ciphers/stream_interface.h>
 #include <testsuite/test_utils/common_functions.h>
@@ -68,3 +70,36 @@ TEST(tsc4, test_vectors) {
 TEST(trivium, test_vectors) {
     testsuite::stream_cipher_test_case("Trivium", 9)();
 }
+
+TEST(stream_state, cipher_context_keeps_the_keystream_position) {
+    const json config = R"({
+        "type": "estream",
+        "algorithm": "Salsa20",
+        "round": 12,
+        "block_size": 16,
+        "plaintext": {"type": "counter"},
+        "key_size": 16,
+        "key": {"type": "pcg32_stream"},
+        "iv": {"type": "false_stream"}
+    })"_json;
+
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto saved = make_stream(config, seeder, map, 64);
+    for (int i = 0; i < 10; ++i)
+        saved->next();
+    std::stringstream state;
+    saved->save_state(state);
+
+    seed_seq_from<pcg32> other_seeder(testsuite::seed1);
+    auto loaded = make_stream(config, other_seeder, map, 64);
+    loaded->load_state(state);
+    for (int i = 0; i < 10; ++i)
+        ASSERT_EQ(saved->next().copy_to_vector(), loaded->next().copy_to_vector()) << i;
+
+    // the context of Grain points to the key, it is not saved
+    json unsaved = config;
+    unsaved["algorithm"] = "Grain";
+    unsaved["round"] = 13;
+    EXPECT_THROW(make_stream(unsaved, seeder, map, 64)->save_state(state), std::runtime_error);
+}
@@ -7,6 +7,9 @@
 #include "gtest/gtest.h"
 #include <eacirc-core/seed.h>
 #include <testsuite/test_utils/test_case.h>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 const static int testing_size = 1536;
 
@@ -46,6 +49,563 @@ TEST(counter_stream, basic_test) {
     }
 }
 
+TEST(counter_stream, endianness_and_step) {
+    // 10 bytes, so the carry runs into a second, partial limb
+    counter little({{"step", 0xc0}}, 10);
+    counter big({{"endianness", "big"}, {"step", 0xc0}}, 10);
+    std::vector<value_type> value(10, 0);
+
+    for (unsigned j = 1; j <= 3000; ++j) {
+        const std::uint64_t expected = std::uint64_t(j) * 0xc0;
+        for (std::size_t k = 0; k < 10; ++k)
+            value[k] = k < 8 ? value_type(expected >> (8 * k)) : 0;
+        ASSERT_EQ(value, little.next().copy_to_vector());
+
+        std::reverse(value.begin(), value.end());
+        ASSERT_EQ(value, big.next().copy_to_vector());
+    }
+
+    // all ones wraps around to zero, through both limbs
+    counter wrapping(10);
+    std::vector<value_type> value_before(10, 0xff);
+    value_before[0] = 0xfe;
+    wrapping.set_data(make_cview(value_before));
+    ASSERT_EQ(std::vector<value_type>(10, 0xff), wrapping.next().copy_to_vector());
+    ASSERT_EQ(std::vector<value_type>(10, 0), wrapping.next().copy_to_vector());
+
+    EXPECT_THROW(counter({{"endianness", "middle"}}, 4), std::runtime_error);
+}
+
+TEST(counter_stream, batch_continues_next) {
+    for (const std::string endianness : {"little", "big"}) {
+        counter reference({{"endianness", endianness}, {"step", 1000}}, 13);
+        counter batched({{"endianness", endianness}, {"step", 1000}}, 13);
+
+        std::vector<value_type> expected;
+        for (int j = 0; j < 100; ++j) {
+            auto view = reference.next();
+            expected.insert(expected.end(), view.begin(), view.end());
+        }
+
+        std::vector<value_type> values(100 * 13);
+        batched.next_batch(values.data(), 60);
+        values.resize(60 * 13);
+        for (int j = 0; j < 40; ++j) {
+            auto view = batched.next();
+            values.insert(values.end(), view.begin(), view.end());
+        }
+        ASSERT_EQ(expected, values) << endianness;
+    }
+}
+
+TEST(rng_streams, fill_versions) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+
+    for (const std::size_t osize : {1u, 7u, 16u}) {
+        seed_seq_from<pcg32> seeder1(testsuite::seed1);
+        seed_seq_from<pcg32> seeder2(testsuite::seed1);
+        seed_seq_from<pcg32> seeder3(testsuite::seed1);
+        pcg32 rng1(seeder1);
+        pcg32 rng2(seeder2);
+        auto per_byte = make_stream({{"type", "pcg32_stream"}}, seeder3, map, osize);
+        seed_seq_from<pcg32> seeder4(testsuite::seed1);
+        auto whole =
+            make_stream({{"type", "pcg32_stream"}, {"rng_version", 2}}, seeder4, map, osize);
+
+        for (int i = 0; i < 10; ++i) {
+            // version 1 keeps the former output, one generator output per byte
+            std::vector<value_type> expected(osize);
+            for (auto &byte : expected)
+                byte = std::uniform_int_distribution<std::uint8_t>()(rng1);
+            ASSERT_EQ(expected, per_byte->next().copy_to_vector());
+
+            // version 2 stores whole outputs, the unused bytes of the last one are dropped
+            for (std::size_t j = 0; j < osize; j += 4) {
+                const std::uint32_t value = rng2();
+                for (std::size_t k = 0; k < 4 && j + k < osize; ++k)
+                    expected[j + k] = value_type(value >> (8 * k));
+            }
+            ASSERT_EQ(expected, whole->next().copy_to_vector());
+        }
+    }
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    EXPECT_THROW(make_stream({{"type", "sac"}, {"rng_version", 3}}, seeder, map, 4),
+                 std::runtime_error);
+}
+
+TEST(rng_streams, pcg32_lanes_are_pcg32_generators) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const std::size_t lanes = pcg32_lanes::lanes;
+
+    // every lane is pcg32 seeded by four words of the seed sequence
+    seed_seq_from<pcg32> seeder1(testsuite::seed1);
+    std::uint32_t seeds[4 * lanes];
+    seeder1.generate(seeds, seeds + 4 * lanes);
+    std::vector<pcg32> generators;
+    for (std::size_t l = 0; l < lanes; ++l)
+        generators.emplace_back(std::uint64_t(seeds[4 * l + 1]) << 32 | seeds[4 * l],
+                                std::uint64_t(seeds[4 * l + 3]) << 32 | seeds[4 * l + 2]);
+
+    // 100 bytes are 3 whole rounds and 4 bytes of the fourth one
+    seed_seq_from<pcg32> seeder2(testsuite::seed1);
+    auto tested = make_stream({{"type", "pcg32_lanes_stream"}}, seeder2, map, 100);
+    for (int i = 0; i < 20; ++i) {
+        std::vector<value_type> expected;
+        for (std::size_t round = 0; round < 4; ++round)
+            for (auto &generator : generators) {
+                const std::uint32_t word = generator();
+                for (std::size_t b = 0; b < 4; ++b)
+                    expected.push_back(value_type(word >> (8 * b)));
+            }
+        expected.resize(100);
+
+        ASSERT_EQ(expected, tested->next().copy_to_vector());
+    }
+}
+
+TEST(bernoulli_distribution_stream, bit_sliced_keeps_p) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const std::size_t osize = 1000;
+
+    for (const double p : {0.0, 0.01, 0.3, 0.5, 0.875, 1.0}) {
+        seed_seq_from<pcg32> seeder(testsuite::seed1);
+        auto stream = make_stream(
+            {{"type", "bernoulli_distribution"}, {"p", p}, {"rng_version", 2}}, seeder, map, osize);
+
+        // the rate of ones is checked for each of the 8 bit positions of a byte
+        std::vector<std::size_t> ones(8, 0);
+        const std::size_t vectors = 100;
+        for (std::size_t i = 0; i < vectors; ++i)
+            for (const auto byte : stream->next())
+                for (std::size_t b = 0; b < 8; ++b)
+                    ones[b] += byte >> b & 1;
+
+        const double count = double(vectors * osize);
+        for (std::size_t b = 0; b < 8; ++b)
+            // more than 6 standard deviations away from p is broken, not unlucky
+            ASSERT_NEAR(p, double(ones[b]) / count, 6 * std::sqrt(0.25 / count) + 1e-12)
+                << "p " << p << " bit " << b;
+    }
+}
+
+TEST(distribution_streams, alias_tables_match_std_distributions) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const std::vector<json> configs = {
+        {{"type", "binomial_distribution"}, {"max_value", 200}, {"p", 0.3}},
+        {{"type", "normal_distribution"}, {"mean", 1}, {"std_dev", 2.0}},
+        {{"type", "poisson_distribution"}, {"mean", 30}},
+        {{"type", "exponential_distribution"}, {"lambda", 1}},
+    };
+    const std::size_t osize = 1 << 10;
+    const std::size_t vectors = 1 << 9;
+
+    for (const auto &config : configs) {
+        std::vector<double> frequencies[2];
+        for (const int version : {1, 2}) {
+            json versioned = config;
+            versioned["rng_version"] = version;
+            seed_seq_from<pcg32> seeder(testsuite::seed1);
+            auto stream = make_stream(versioned, seeder, map, osize);
+
+            frequencies[version - 1].assign(256, 0.0);
+            for (std::size_t i = 0; i < vectors; ++i)
+                for (const auto byte : stream->next())
+                    frequencies[version - 1][byte] += 1.0 / double(osize * vectors);
+        }
+
+        // both samples of 2^19 bytes come from the same distribution
+        double distance = 0;
+        for (std::size_t k = 0; k < 256; ++k)
+            distance += std::abs(frequencies[0][k] - frequencies[1][k]) / 2;
+        ASSERT_LT(distance, 0.02) << config;
+    }
+}
+
+TEST(distribution_streams, alias_table_keeps_weights) {
+    std::vector<double> weights(256, 0.0);
+    for (std::size_t k = 0; k < 256; ++k)
+        weights[k] = k % 3 == 0 ? 0.0 : double(k * k % 101);
+    const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    const _impl::alias_table table(weights);
+    double sum = 0;
+    for (std::size_t k = 0; k < 256; ++k) {
+        ASSERT_NEAR(weights[k] / total, table.probability(value_type(k)), 1e-9) << k;
+        sum += table.probability(value_type(k));
+    }
+    ASSERT_DOUBLE_EQ(1.0, sum);
+
+    EXPECT_THROW(_impl::alias_table(std::vector<double>(256, 0.0)), std::runtime_error);
+}
+
+TEST(file_stream, offset_stride_limit_and_loop) {
+    const std::string path = "file_stream_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (int i = 0; i < 100; ++i)
+            file.put(char(i));
+    }
+    // first bytes of the vectors read, osize is 10
+    const auto expect = [&path](json config, const std::vector<int> &starts, bool ends) {
+        config["path"] = path;
+        for (const bool mapped : {false, true}) {
+            config["mmap"] = mapped;
+            file_stream stream(config, 10);
+            for (const int start : starts) {
+                std::vector<value_type> expected(10);
+                std::iota(expected.begin(), expected.end(), value_type(start));
+                ASSERT_EQ(expected, stream.next().copy_to_vector()) << config;
+            }
+            if (ends) {
+                EXPECT_THROW(stream.next(), std::runtime_error) << config;
+            }
+        }
+    };
+
+    expect({}, {0, 10, 20, 30, 40, 50, 60, 70, 80, 90}, true);
+    expect({{"offset", 3}, {"stride", 20}, {"limit", 3}}, {3, 23, 43}, true);
+    expect({{"offset", 75}, {"stride", 5}}, {75, 80, 85, 90}, true);
+    expect({{"offset", 50}, {"loop", true}}, {50, 60, 70, 80, 90, 50, 60}, false);
+    expect({{"stride", 30}, {"limit", 2}, {"loop", true}}, {0, 30, 0, 30, 0}, false);
+    expect({{"offset", 95}, {"loop", true}}, {}, true);
+
+    std::remove(path.c_str());
+}
+
+TEST(combine_stream, matches_folded_inputs) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json source = {{"type", "pcg32_stream"}};
+    // 100 bytes is neither a whole number of SIMD chunks nor of 64-bit words
+    const std::size_t osize = 100;
+
+    // reference fold of in into out, word by word for the additions
+    const auto fold = [](std::vector<value_type> &out, const value_type *in, std::size_t word) {
+        for (std::size_t i = 0; i < out.size(); i += word) {
+            unsigned carry = 0;
+            for (std::size_t j = i; j < std::min(i + word, out.size()); ++j) {
+                carry += unsigned(out[j]) + in[j];
+                out[j] = value_type(carry);
+                carry >>= 8;
+            }
+        }
+    };
+    const std::vector<std::pair<std::string, std::size_t>> additions = {
+        {"add8", 1}, {"add16", 2}, {"add32", 4}, {"add64", 8}};
+
+    for (const auto &addition : additions) {
+        seed_seq_from<pcg32> seeder(testsuite::seed1);
+        const json config = {{"type", "combine"},
+                             {"operation", addition.first},
+                             {"sources", {source, source, source}}};
+        auto combined = make_stream(config, seeder, map, osize);
+
+        seed_seq_from<pcg32> same_seeder(testsuite::seed1);
+        std::vector<std::unique_ptr<stream>> inputs;
+        for (int i = 0; i < 3; ++i)
+            inputs.push_back(make_stream(source, same_seeder, map, osize));
+
+        for (int n = 0; n < 3; ++n) {
+            std::vector<value_type> expected = inputs[0]->next().copy_to_vector();
+            for (std::size_t i = 1; i < 3; ++i)
+                fold(expected, inputs[i]->next().copy_to_vector().data(), addition.second);
+            ASSERT_EQ(expected, combined->next().copy_to_vector()) << addition.first;
+        }
+    }
+
+    for (const std::string operation : {"xor", "and", "or"}) {
+        seed_seq_from<pcg32> seeder(testsuite::seed1);
+        auto combined = make_stream(
+            {{"type", "combine"}, {"operation", operation}, {"source", source}, {"segments", 3}},
+            seeder,
+            map,
+            osize);
+
+        seed_seq_from<pcg32> same_seeder(testsuite::seed1);
+        auto input = make_stream(source, same_seeder, map, 3 * osize);
+
+        for (int n = 0; n < 3; ++n) {
+            const std::vector<value_type> segments = input->next().copy_to_vector();
+            std::vector<value_type> expected(segments.begin(), segments.begin() + osize);
+            for (std::size_t i = 0; i < osize; ++i) {
+                for (std::size_t s = 1; s < 3; ++s) {
+                    const value_type value = segments[s * osize + i];
+                    if (operation == "xor")
+                        expected[i] ^= value;
+                    else if (operation == "and")
+                        expected[i] &= value;
+                    else
+                        expected[i] |= value;
+                }
+            }
+            ASSERT_EQ(expected, combined->next().copy_to_vector()) << operation;
+        }
+    }
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    EXPECT_THROW(make_stream({{"type", "combine"}, {"operation", "sub8"}, {"source", source}},
+                             seeder,
+                             map,
+                             osize),
+                 std::runtime_error);
+}
+
+TEST(stream_types, registry_lookup) {
+    const std::vector<std::string> names = stream_types().names();
+    EXPECT_TRUE(std::is_sorted(names.begin(), names.end()));
+    for (const std::string type : {"counter", "pcg32_stream", "random_stream", "combine", "hash"})
+        EXPECT_NE(nullptr, stream_types().find(type)) << type;
+    EXPECT_EQ(nullptr, stream_types().find("no_such_stream"));
+
+    registry<int> numbers = {{"one", 1}, {"two", 2}};
+    EXPECT_EQ(2, *numbers.find("two"));
+    EXPECT_THROW(numbers.add("one", 3), std::logic_error);
+
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    EXPECT_THROW(make_stream({{"type", "no_such_stream"}}, seeder, map, 16), std::runtime_error);
+}
+
+TEST(combine_stream, compiled_from_nested_folds) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json source = {{"type", "pcg32_stream"}};
+    const json nested = {
+        {"type", "xor_stream"},
+        {"source",
+         {{"type", "combine"},
+          {"segments", 3},
+          {"source", {{"type", "xor_stream"}, {"source", source}}}}}};
+
+    const json compiled = compile_stream(nested, 20);
+    EXPECT_EQ("combine", compiled.at("type"));
+    EXPECT_EQ(12, compiled.at("segments"));
+    EXPECT_EQ(source, compiled.at("source"));
+
+    // the interpreted chain, every fold on its own
+    json interpreted = nested;
+    interpreted["fuse"] = false;
+    interpreted["source"]["fuse"] = false;
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto tested = make_stream(nested, seeder, map, 20);
+    seed_seq_from<pcg32> same_seeder(testsuite::seed1);
+    auto reference = make_stream(interpreted, same_seeder, map, 20);
+    for (int i = 0; i < 3; ++i)
+        ASSERT_EQ(reference->next().copy_to_vector(), tested->next().copy_to_vector());
+
+    // different operations do not fold together
+    const json mixed = {{"type", "combine"},
+                        {"operation", "add8"},
+                        {"source", {{"type", "xor_stream"}, {"source", source}}}};
+    EXPECT_EQ(mixed, compile_stream(mixed, 20));
+}
+
+TEST(combine_stream, additions_fold_together_on_whole_words) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json source = {{"type", "pcg32_stream"}};
+
+    for (const std::string operation : {"add16", "add32", "add64"}) {
+        const json nested = {
+            {"type", "combine"},
+            {"operation", operation},
+            {"source", {{"type", "combine"}, {"operation", operation}, {"source", source}}}};
+        json interpreted = nested;
+        interpreted["fuse"] = false;
+        interpreted["source"]["fuse"] = false;
+
+        EXPECT_EQ("combine", compile_stream(nested, 24).at("type"));
+        EXPECT_EQ(4, compile_stream(nested, 24).at("segments"));
+        // the words of the inner fold would cross the outer segments of 3 bytes
+        EXPECT_EQ(nested, compile_stream(nested, 3));
+
+        for (const std::size_t osize : {3u, 24u}) {
+            seed_seq_from<pcg32> seeder(testsuite::seed1);
+            auto tested = make_stream(nested, seeder, map, osize);
+            seed_seq_from<pcg32> same_seeder(testsuite::seed1);
+            auto reference = make_stream(interpreted, same_seeder, map, osize);
+            for (int i = 0; i < 3; ++i)
+                ASSERT_EQ(reference->next().copy_to_vector(), tested->next().copy_to_vector())
+                    << operation << " osize " << osize;
+        }
+    }
+}
+
+TEST(shared_stream, identical_subgraphs_read_the_same_vectors) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json subgraph = {{"type", "xor_stream"}, {"source", {{"type", "counter"}}}};
+    // the second repeating stream reads the shared subgraph far behind the first one
+    const auto tuple = [](const json &source) {
+        return json{{"type", "tuple_stream"},
+                    {"sources",
+                     {{{"type", "repeating_stream"},
+                       {"period", 1},
+                       {"output_size", 8},
+                       {"source", source}},
+                      {{"type", "repeating_stream"},
+                       {"period", 40},
+                       {"output_size", 8},
+                       {"source", source}}}}};
+    };
+    json single = subgraph;
+    single["share"] = false;
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto tested = make_stream(tuple(subgraph), seeder, map, 16);
+    auto reference = make_stream(tuple(single), seeder, map, 16);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(reference->next().copy_to_vector(), tested->next().copy_to_vector()) << i;
+
+    // a seeded subgraph is shared on request only, then both halves are the same stream
+    const json random = {{"type", "xor_stream"}, {"source", {{"type", "pcg32_stream"}}}};
+    json shared_random = random;
+    shared_random["share"] = true;
+    const auto halves = [&](const json &source) {
+        const json half = {
+            {"type", "single_value_stream"}, {"output_size", 8}, {"source", source}};
+        const json pair = {{"type", "tuple_stream"}, {"sources", {half, half}}};
+        const auto vector = make_stream(pair, seeder, map, 16)->next().copy_to_vector();
+        return std::equal(vector.begin(), vector.begin() + 8, vector.begin() + 8);
+    };
+    EXPECT_FALSE(halves(random));
+    EXPECT_TRUE(halves(shared_random));
+}
+
+TEST(shared_stream, seeded_subgraph_read_far_apart_is_rejected) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json random = {
+        {"type", "xor_stream"}, {"source", {{"type", "pcg32_stream"}}}, {"share", true}};
+    // the second occurrence is read once in a long while, like the key of a block cipher
+    const json config = {
+        {"type", "tuple_stream"},
+        {"sources",
+         {{{"type", "repeating_stream"}, {"period", 1}, {"output_size", 4096}, {"source", random}},
+          {{"type", "repeating_stream"},
+           {"period", 1000000},
+           {"output_size", 4096},
+           {"source", random}}}}};
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto stream = make_stream(config, seeder, map, 8192);
+    // both have read the first vector, the ones after it are kept for the second up to the limit
+    const std::size_t kept = _impl::shared_source::max_kept_size / 4096;
+    for (std::size_t i = 0; i <= kept; ++i)
+        ASSERT_NO_THROW(stream->next()) << i;
+    EXPECT_THROW(stream->next(), std::runtime_error);
+}
+
+TEST(shared_stream, graphs_on_threads_read_the_same_vectors) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json random = {{"type", "pcg32_stream"}, {"share", true}};
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto first = make_stream(random, seeder, map, 16);
+    // a graph of its own reading the subgraph shared in the first one, as the variants of a sweep
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> other_map;
+    add_shared_subgraphs(map, other_map);
+    auto second = make_stream(random, seeder, other_map, 16);
+
+    std::vector<std::vector<value_type>> first_vectors;
+    std::thread reader([&] {
+        for (unsigned i = 0; i < 1000; ++i)
+            first_vectors.push_back(first->next().copy_to_vector());
+    });
+    std::vector<std::vector<value_type>> second_vectors;
+    for (unsigned i = 0; i < 1000; ++i)
+        second_vectors.push_back(second->next().copy_to_vector());
+    reader.join();
+
+    EXPECT_EQ(first_vectors, second_vectors);
+}
+
+TEST(shared_stream, subgraph_reading_a_file_is_not_shared) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    const json counter = {{"type", "xor_stream"}, {"source", {{"type", "counter"}}}};
+    EXPECT_NE(nullptr, dynamic_cast<shared_stream *>(make_stream(counter, seeder, map, 8).get()));
+
+    // a file may be a pipe, a copy reading it again would not read the same vectors
+    const json file = {{"type", "xor_stream"},
+                       {"source", {{"type", "file_stream"}, {"path", "/dev/zero"}}}};
+    EXPECT_EQ(nullptr, dynamic_cast<shared_stream *>(make_stream(file, seeder, map, 8).get()));
+}
+
+TEST(shared_stream, named_subgraph_is_shared_when_it_starts_the_same) {
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    const json random = {{"type", "pcg32_stream"}, {"share", "plaintext"}};
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto first = make_stream(random, seeder, map, 16);
+
+    // built with a seeder of its own, as the variants of a sweep
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> same_map;
+    add_shared_subgraphs(map, same_map);
+    seed_seq_from<pcg32> same_seeder(testsuite::seed1);
+    auto same = make_stream(random, same_seeder, same_map, 16);
+    EXPECT_NE(nullptr, dynamic_cast<shared_stream *>(same.get()));
+
+    // the seeder gives it another state, it is not the shared stream
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> other_map;
+    add_shared_subgraphs(map, other_map);
+    seed_seq_from<pcg32> other_seeder(seed::create("0000000000000001"));
+    auto other = make_stream(random, other_seeder, other_map, 16);
+    EXPECT_EQ(nullptr, dynamic_cast<shared_stream *>(other.get()));
+
+    for (unsigned i = 0; i < 100; ++i) {
+        const auto vector = first->next().copy_to_vector();
+        ASSERT_EQ(vector, same->next().copy_to_vector()) << i;
+        ASSERT_NE(vector, other->next().copy_to_vector()) << i;
+    }
+
+    // inputs of the same config under other names are seeded each on its own
+    const json inputs = R"({
+        "type": "tuple_stream",
+        "sources": [
+            {"type": "pcg32_stream", "output_size": 16, "share": "key"},
+            {"type": "pcg32_stream", "output_size": 16, "share": "plaintext"}
+        ]
+    })"_json;
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> tuple_map;
+    seed_seq_from<pcg32> tuple_seeder(testsuite::seed1);
+    const auto tuple = make_stream(inputs, tuple_seeder, tuple_map, 32)->next().copy_to_vector();
+    EXPECT_FALSE(std::equal(tuple.begin(), tuple.begin() + 16, tuple.begin() + 16));
+}
+
+TEST(stream_state, loaded_stream_continues_the_saved_one) {
+    const json config = R"({
+        "type": "tuple_stream",
+        "sources": [
+            {"type": "counter", "output_size": 8},
+            {"type": "pcg32_stream", "output_size": 8},
+            {"type": "hw_counter", "hw": 2, "output_size": 8},
+            {"type": "column", "size": 2, "output_size": 8, "source": {"type": "mt19937_stream"}},
+            {"type": "xor_stream", "output_size": 8, "source": {"type": "counter"}},
+            {"type": "block", "init_frequency": "3", "algorithm": "AES", "round": 10,
+             "block_size": 16, "output_size": 16, "plaintext": {"type": "pcg32_stream"},
+             "key_size": 16, "key": {"type": "pcg32_stream"}, "iv": {"type": "false_stream"}}
+        ]
+    })"_json;
+
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto saved = make_stream(config, seeder, map, 56);
+    for (int i = 0; i < 50; ++i)
+        saved->next();
+    std::stringstream state;
+    saved->save_state(state);
+
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> other_map;
+    seed_seq_from<pcg32> other_seeder(testsuite::seed1);
+    auto loaded = make_stream(config, other_seeder, other_map, 56);
+    loaded->load_state(state);
+    for (int i = 0; i < 100; ++i)
+        ASSERT_EQ(saved->next().copy_to_vector(), loaded->next().copy_to_vector()) << i;
+
+    // a stage on a worker has no state to save, the run is replayed instead
+    json async = config;
+    async["async"] = true;
+    auto async_stream = make_stream(async, seeder, map, 56);
+    EXPECT_THROW(async_stream->save_state(state), std::runtime_error);
+}
+
 TEST(sac_streams, basic_test) {
     seed_seq_from<pcg32> seeder(testsuite::seed1);
     std::unique_ptr<sac_stream> stream = std::make_unique<sac_stream>(seeder, 16);
@@ -193,6 +753,44 @@ TEST(hw_counter, period_test) {
     }
 }
 
+TEST(hw_counter, seek_matches_sequential_output) {
+    const std::vector<std::pair<json, std::size_t>> configs = {
+        {{{"hw", 1}}, 1}, // wraps around all weights several times
+        {{{"hw", 3}, {"increase_hw", false}}, 4},
+        {{{"hw", 2}, {"increase_hw", false}, {"randomize_overflow", true}}, 2},
+        {{{"hw", 2}, {"randomize_start", true}}, 9}, // wider than 64 bits
+    };
+    const std::size_t length = 3000;
+
+    for (const auto &config : configs) {
+        seed_seq_from<pcg32> seeder1(testsuite::seed1);
+        hw_counter sequential(config.first, seeder1, config.second);
+        std::vector<std::vector<value_type>> expected;
+        for (std::size_t i = 0; i < length; ++i)
+            expected.push_back(sequential.next().copy_to_vector());
+
+        seed_seq_from<pcg32> seeder2(testsuite::seed1);
+        hw_counter random_access(config.first, seeder2, config.second);
+        for (std::size_t i = 0; i < 200; ++i) {
+            const std::size_t index = (i * 7919) % length;
+            random_access.seek(index);
+            ASSERT_EQ(expected[index], random_access.next().copy_to_vector())
+                << config.first << " index " << index;
+        }
+
+        // shards starting at given indices continue the same sequence
+        for (const std::size_t start : {0u, 1u, 1000u, 2999u}) {
+            json sharded = config.first;
+            sharded["start_index"] = start;
+            seed_seq_from<pcg32> seeder3(testsuite::seed1);
+            hw_counter shard(sharded, seeder3, config.second);
+            for (std::size_t i = start; i < std::min(length, start + 500); ++i)
+                ASSERT_EQ(expected[i], shard.next().copy_to_vector())
+                    << config.first << " index " << i;
+        }
+    }
+}
+
 TEST(column_streams, test_with_counter) {
     json json_config = R"({
        "type": "column_stream",
@@ -400,6 +998,31 @@ TEST(column_streams, test_with_counter) {
 
 }
 
+TEST(column_streams, bit_by_bit_transposition) {
+    const json config = {{"type", "column"}, {"size", 3}, {"source", {{"type", "pcg32_stream"}}}};
+    const std::size_t osize = 5;
+
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder1(testsuite::seed1);
+    seed_seq_from<pcg32> seeder2(testsuite::seed1);
+    auto tested = make_stream(config, seeder1, map, osize);
+    auto source = make_stream(config.at("source"), seeder2, map, 3);
+
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::vector<value_type>> rows;
+        for (std::size_t i = 0; i < osize * 8; ++i)
+            rows.push_back(source->next().copy_to_vector());
+
+        for (std::size_t j = 0; j < 3 * 8; ++j) {
+            std::vector<value_type> expected(osize);
+            for (std::size_t i = 0; i < osize * 8; ++i)
+                expected[i / 8] |= ((rows[i][j / 8] >> (7 - j % 8)) & 1) << (7 - i % 8);
+
+            ASSERT_EQ(expected, tested->next().copy_to_vector());
+        }
+    }
+}
+
 TEST(rnd_plt_ctx_streams, aes_single_vector) {
     const json json_config = R"({
          "type": "tuple_stream",
@@ -577,3 +1200,175 @@ TEST(pipe_streams, pipe_out_fist) {
         ASSERT_EQ(in_view.copy_to_vector(), out_view.copy_to_vector());
     }
 }
+
+TEST(pipe_streams, every_pipe_stream_reads_every_vector) {
+    const json counter = {{"type", "counter"}};
+    const json json_out = {{"type", "pipe_out_stream"}, {"id", "id"}};
+
+    for (const bool concurrent : {false, true}) {
+        const json json_in = {{"type", "pipe_in_stream"},
+                              {"id", "id"},
+                              {"capacity", 4},
+                              {"concurrent", concurrent},
+                              {"source", counter}};
+        seed_seq_from<pcg32> seeder(testsuite::seed1);
+        std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+
+        auto reference = make_stream(counter, seeder, map, 16);
+        std::vector<std::vector<value_type>> expected;
+        for (unsigned i = 0; i < 100; ++i)
+            expected.push_back(reference->next().copy_to_vector());
+
+        auto pipe_out = make_stream(json_out, seeder, map, 16);
+        auto pipe_in = make_stream(json_in, seeder, map, 16);
+        auto other_out = make_stream(json_out, seeder, map, 16);
+
+        // pipe streams in turns up to 2 vectors apart, a concurrent pipe is read by a thread too
+        std::vector<std::vector<value_type>> other;
+        const auto read_other = [&] { other.push_back(other_out->next().copy_to_vector()); };
+        std::thread reader;
+        if (concurrent)
+            reader = std::thread([&] {
+                for (unsigned i = 0; i < 100; ++i)
+                    read_other();
+            });
+        for (unsigned i = 0; i < 100; ++i) {
+            ASSERT_EQ(expected[i], pipe_in->next().copy_to_vector()) << concurrent;
+            if (i % 2 == 1) {
+                ASSERT_EQ(expected[i - 1], pipe_out->next().copy_to_vector()) << concurrent;
+                ASSERT_EQ(expected[i], pipe_out->next().copy_to_vector()) << concurrent;
+            }
+            if (!concurrent)
+                read_other();
+        }
+        if (concurrent)
+            reader.join();
+        EXPECT_EQ(expected, other) << concurrent;
+
+        if (!concurrent) {
+            // capacity - 1 vectors ahead of the pipe streams left behind, the ring is full
+            for (unsigned i = 0; i < 3; ++i)
+                pipe_in->next();
+            EXPECT_THROW(pipe_in->next(), std::runtime_error);
+        }
+    }
+}
+
+TEST(async_streams, stages_give_the_same_output_on_workers) {
+    json config = R"({
+         "type": "block",
+         "init_frequency": "only_once",
+         "algorithm": "AES",
+         "round": 10,
+         "block_size": 16,
+         "plaintext": {
+             "type": "pcg32_stream"
+         },
+         "key_size": 16,
+         "key": {
+             "type": "false_stream"
+         },
+         "iv": {
+             "type": "false_stream"
+         }
+     })"_json;
+
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    auto inline_stages = make_stream(config, seeder, map, 48);
+
+    // both stages on workers, a batch the reads do not end with
+    config["async"] = true;
+    config["batch"] = 5;
+    config["queue"] = 2;
+    config["plaintext"]["async"] = true;
+    seed_seq_from<pcg32> async_seeder(testsuite::seed1);
+    auto async_stages = make_stream(config, async_seeder, map, 48);
+    ASSERT_EQ(48, async_stages->osize());
+
+    for (unsigned i = 0; i < 37; ++i)
+        ASSERT_EQ(inline_stages->next().copy_to_vector(), async_stages->next().copy_to_vector());
+}
+
+TEST(async_streams, source_ending_within_a_batch_gives_its_last_vectors) {
+    const std::string path = "async_stream_test.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (int i = 0; i < 100; ++i)
+            file.put(char(i));
+    }
+    // 7 vectors of 10 bytes, the second batch of 4 has only 3 of them
+    json config = {{"type", "file_stream"}, {"path", path}, {"limit", 7}};
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+    seed_seq_from<pcg32> seeder(testsuite::seed1);
+    auto inline_stage = make_stream(config, seeder, map, 10);
+    config["async"] = true;
+    config["batch"] = 4;
+    config["queue"] = 2;
+    auto async_stage = make_stream(config, seeder, map, 10);
+
+    for (unsigned i = 0; i < 7; ++i)
+        ASSERT_EQ(inline_stage->next().copy_to_vector(), async_stage->next().copy_to_vector())
+            << i;
+    EXPECT_THROW(inline_stage->next(), std::runtime_error);
+    EXPECT_THROW(async_stage->next(), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(column_streams, fixed_positions_in_one_batch) {
+    const json source = {{"type", "pcg32_stream"}};
+    const std::vector<std::size_t> positions = {17, 0, 9, 23, 8};
+    const std::size_t osize = 4;
+    std::unordered_map<std::string, std::shared_ptr<std::unique_ptr<stream>>> map;
+
+    // all positions at once are the columns of the column stream
+    seed_seq_from<pcg32> seeder1(testsuite::seed1);
+    seed_seq_from<pcg32> seeder2(testsuite::seed1);
+    auto all = make_stream(
+        {{"type", "column_fixed_position"}, {"size", 3}, {"positions", "all"}, {"source", source}},
+        seeder1,
+        map,
+        osize);
+    auto columns =
+        make_stream({{"type", "column"}, {"size", 3}, {"source", source}}, seeder2, map, osize);
+    for (std::size_t i = 0; i < 2 * 3 * 8; ++i)
+        ASSERT_EQ(columns->next().copy_to_vector(), all->next().copy_to_vector());
+
+    // a single position takes a new batch each time, a list takes one batch per turn
+    seed_seq_from<pcg32> seeder3(testsuite::seed1);
+    seed_seq_from<pcg32> seeder4(testsuite::seed1);
+    auto listed = make_stream({{"type", "column_fixed_position"},
+                               {"size", 3},
+                               {"positions", positions},
+                               {"source", source}},
+                              seeder3,
+                              map,
+                              osize);
+    auto batches =
+        make_stream({{"type", "column"}, {"size", 3}, {"source", source}}, seeder4, map, osize);
+    for (int turn = 0; turn < 2; ++turn) {
+        std::vector<std::vector<value_type>> batch;
+        for (std::size_t j = 0; j < 3 * 8; ++j)
+            batch.push_back(batches->next().copy_to_vector());
+
+        for (const std::size_t position : positions)
+            ASSERT_EQ(batch[position], listed->next().copy_to_vector());
+    }
+
+    seed_seq_from<pcg32> seeder5(testsuite::seed1);
+    seed_seq_from<pcg32> seeder6(testsuite::seed1);
+    auto single = make_stream(
+        {{"type", "column_fixed_position"}, {"size", 3}, {"position", 9}, {"source", source}},
+        seeder5,
+        map,
+        osize);
+    auto reference =
+        make_stream({{"type", "column"}, {"size", 3}, {"source", source}}, seeder6, map, osize);
+    for (int turn = 0; turn < 3; ++turn) {
+        std::vector<std::vector<value_type>> batch;
+        for (std::size_t j = 0; j < 3 * 8; ++j)
+            batch.push_back(reference->next().copy_to_vector());
+
+        ASSERT_EQ(batch[9], single->next().copy_to_vector());
+    }
+}
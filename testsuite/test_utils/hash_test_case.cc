@@ -1,4 +1,5 @@
 #include "hash_test_case.h"
+#include <cstring>
 #include <gtest/gtest.h>
 #include <iomanip>
 #include <ios>
@@ -31,6 +32,39 @@ void hash_test_case::test() const {
         throw std::runtime_error("cannot finalize the hash (code: " + to_string(status) + ")");
 
     ASSERT_EQ(hash, _ciphertext);
+
+    if (_length % 8 == 0) {
+        // byte-oriented path has to give the same digest as the bit-oriented one
+        std::fill(hash.begin(), hash.end(), 0);
+
+        hasher->Init(int(hash_size * 8));
+        status = hasher->update_bytes(_plaintext.data(), _length / 8);
+        if (status != 0)
+            throw std::runtime_error("cannot update the hash (code: " + to_string(status) + ")");
+        hasher->Final(hash.data());
+
+        ASSERT_EQ(hash, _ciphertext);
+    }
+
+    if (hasher->context_size() != 0) {
+        // restoring the context saved right after Init has to work as well as calling Init
+        hasher->Init(int(hash_size * 8));
+        auto context = static_cast<std::uint8_t *>(hasher->context());
+        const std::vector<std::uint8_t> initial(context, context + hasher->context_size());
+
+        for (int i = 0; i < 2; ++i) {
+            std::fill(hash.begin(), hash.end(), 0);
+            std::memcpy(hasher->context(), initial.data(), initial.size());
+
+            status = hasher->Update(_plaintext.data(), _length);
+            if (status != 0)
+                throw std::runtime_error("cannot update the hash (code: " + to_string(status) +
+                                         ")");
+            hasher->Final(hash.data());
+
+            ASSERT_EQ(hash, _ciphertext);
+        }
+    }
 }
 
 void hash_test_case::operator()() {